@@ -0,0 +1,299 @@
+#include "stdafx.h"
+#include "EDirectionField.h"
+
+#include "EIntegrationField.h"
+#include "../EliteGridGraph/EGridGraph.h"
+
+#include <cstring>
+
+// Widest instruction set the compiler targets, ELITE_NO_SIMD forces the scalar path
+#if !defined(ELITE_NO_SIMD) && defined(__AVX2__)
+	#define ELITE_DIRECTION_FIELD_AVX2
+	#include <immintrin.h>
+#elif !defined(ELITE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define ELITE_DIRECTION_FIELD_SSE2
+	#include <emmintrin.h>
+#endif
+
+using namespace Elite;
+
+void DirectionField::Calculate(const GridGraph* pGraph, const std::vector<float>& costs, bool isConnectedDiagonally)
+{
+	Calculate(pGraph->GetDenseGrid(), costs, isConnectedDiagonally);
+}
+
+void DirectionField::Calculate(const DenseGrid& grid, const std::vector<float>& costs, bool isConnectedDiagonally)
+{
+	m_NrOfColumns = grid.GetColumns();
+	m_NrOfRows = grid.GetRows();
+	m_NrOfDirections = isConnectedDiagonally ? DenseGrid::NR_OF_DIRECTIONS : DenseGrid::NR_OF_DIRECTIONS / 2;
+	m_Cells.resize(costs.size());
+
+	PadCosts(costs);
+
+	for (int row = 0; row < m_NrOfRows; ++row)
+	{
+		CalculateRow(grid, costs, row);
+	}
+}
+
+void DirectionField::CalculateAtNode(const GridGraph* pGraph, const std::vector<float>& costs, int nodeId)
+{
+	CalculateAtNode(pGraph->GetDenseGrid(), costs, nodeId);
+}
+
+void DirectionField::CalculateAtNode(const DenseGrid& grid, const std::vector<float>& costs, int nodeId)
+{
+	m_Cells[nodeId] = CalculateCell(grid, costs, nodeId);
+}
+
+void DirectionField::Restore(const GridGraph* pGraph, const std::vector<uint8_t>& cells)
+{
+	m_NrOfColumns = pGraph->GetColumns();
+	m_NrOfRows = pGraph->GetRows();
+	m_Cells = cells;
+}
+
+void DirectionField::Clear(const GridGraph* pGraph)
+{
+	m_NrOfColumns = pGraph->GetColumns();
+	m_NrOfRows = pGraph->GetRows();
+	m_Cells.assign(static_cast<size_t>(m_NrOfColumns) * m_NrOfRows, 0);
+}
+
+// Sweeps the 4 quadrants around the goal outwards, so the neighbours towards the goal are always done before the cell itself.
+// The cells on the axes are part of 2 quadrants and get the same result in both.
+void DirectionField::CalculateLineOfSight(const GridGraph* pGraph, int goalNodeId)
+{
+	CalculateLineOfSight(pGraph->GetDenseGrid(), goalNodeId);
+}
+
+void DirectionField::CalculateLineOfSight(const GridGraph* pGraph, int goalNodeId, const std::vector<int>& changedNodeIds)
+{
+	CalculateLineOfSight(pGraph->GetDenseGrid(), goalNodeId, changedNodeIds);
+}
+
+void DirectionField::CalculateLineOfSight(const DenseGrid& grid, int goalNodeId)
+{
+	for (uint8_t& cell : m_Cells)
+	{
+		cell &= ~FlowFieldCell::LINE_OF_SIGHT;
+	}
+
+	if (goalNodeId < 0 || goalNodeId >= static_cast<int>(m_Cells.size()) || !FlowFieldCell::IsPathable(m_Cells[goalNodeId]))
+		return;
+
+	for (int quadrant = 0; quadrant < 4; ++quadrant)
+	{
+		CalculateQuadrantLineOfSight(grid, goalNodeId, quadrant, 0, 0);
+	}
+}
+
+void DirectionField::CalculateLineOfSight(const DenseGrid& grid, int goalNodeId, const std::vector<int>& changedNodeIds)
+{
+	// Without a pathable goal no cell has line of sight, the full pass clears them all
+	if (goalNodeId < 0 || goalNodeId >= static_cast<int>(m_Cells.size()) || !FlowFieldCell::IsPathable(m_Cells[goalNodeId]))
+	{
+		CalculateLineOfSight(grid, goalNodeId);
+		return;
+	}
+
+	const int goalCol{ goalNodeId % m_NrOfColumns };
+	const int goalRow{ goalNodeId / m_NrOfColumns };
+
+	// A cell only depends on the cells between it and the goal, so a change can only shadow the cells of its quadrant
+	// that are at least as far from the goal on both axes. Only that part of every quadrant is swept again.
+	for (int quadrant = 0; quadrant < 4; ++quadrant)
+	{
+		const int stepCol{ quadrant % 2 == 0 ? 1 : -1 };
+		const int stepRow{ quadrant / 2 == 0 ? 1 : -1 };
+
+		int firstColDistance{ m_NrOfColumns };
+		int firstRowDistance{ m_NrOfRows };
+		for (int nodeId : changedNodeIds)
+		{
+			const int colDistance{ (nodeId % m_NrOfColumns - goalCol) * stepCol };
+			const int rowDistance{ (nodeId / m_NrOfColumns - goalRow) * stepRow };
+			if (colDistance < 0 || rowDistance < 0)
+				continue;
+
+			firstColDistance = min(firstColDistance, colDistance);
+			firstRowDistance = min(firstRowDistance, rowDistance);
+		}
+
+		CalculateQuadrantLineOfSight(grid, goalNodeId, quadrant, firstColDistance, firstRowDistance);
+	}
+}
+
+void DirectionField::PadCosts(const std::vector<float>& costs)
+{
+	const int paddedColumns{ m_NrOfColumns + 2 };
+	m_PaddedCosts.assign(static_cast<size_t>(paddedColumns) * (m_NrOfRows + 2), IntegrationField::UNREACHABLE_COST);
+
+	for (int row = 0; row < m_NrOfRows; ++row)
+	{
+		std::copy_n(costs.begin() + static_cast<size_t>(row) * m_NrOfColumns, m_NrOfColumns, m_PaddedCosts.begin() + static_cast<size_t>(row + 1) * paddedColumns + 1);
+	}
+}
+
+// Per block of cells: start from the cell's own cost as a goal and keep the direction of every connected neighbour that is cheaper,
+// the same comparisons as CalculateCell but on 8 (AVX2) or 4 (SSE2) cells at once. The rest of the row goes through CalculateCell.
+void DirectionField::CalculateRow(const DenseGrid& grid, const std::vector<float>& costs, int row)
+{
+	int col{ 0 };
+
+#if defined(ELITE_DIRECTION_FIELD_AVX2) || defined(ELITE_DIRECTION_FIELD_SSE2)
+	const int paddedColumns{ m_NrOfColumns + 2 };
+	int paddedOffsets[DenseGrid::NR_OF_DIRECTIONS]{};
+	for (int direction = 0; direction < m_NrOfDirections; ++direction)
+	{
+		paddedOffsets[direction] = DenseGrid::DIRECTION_OFFSETS[direction][1] * paddedColumns + DenseGrid::DIRECTION_OFFSETS[direction][0];
+	}
+
+	const float* pRowCosts{ &m_PaddedCosts[static_cast<size_t>(row + 1) * paddedColumns + 1] };
+	const uint8_t* pRowMasks{ grid.GetNeighborMasks() + static_cast<size_t>(row) * m_NrOfColumns };
+	uint8_t* pRowCells{ &m_Cells[static_cast<size_t>(row) * m_NrOfColumns] };
+#endif
+
+#if defined(ELITE_DIRECTION_FIELD_AVX2)
+	const __m256 unreachable{ _mm256_set1_ps(IntegrationField::UNREACHABLE_COST) };
+	const __m256i goal{ _mm256_set1_epi32(FlowFieldCell::PATHABLE | FlowFieldCell::GOAL) };
+
+	for (; col + 8 <= m_NrOfColumns; col += 8)
+	{
+		const float* pCosts{ pRowCosts + col };
+		const __m256 ownCosts{ _mm256_loadu_ps(pCosts) };
+		const __m256i masks{ _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pRowMasks + col))) };
+
+		__m256 lowestCosts{ ownCosts };
+		__m256 cells{ _mm256_castsi256_ps(goal) };
+		for (int direction = 0; direction < m_NrOfDirections; ++direction)
+		{
+			const __m256i bit{ _mm256_set1_epi32(1 << direction) };
+			const __m256 hasConnection{ _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(masks, bit), bit)) };
+			const __m256 neighborCosts{ _mm256_loadu_ps(pCosts + paddedOffsets[direction]) };
+			const __m256 isLower{ _mm256_and_ps(hasConnection, _mm256_cmp_ps(neighborCosts, lowestCosts, _CMP_LT_OQ)) };
+
+			lowestCosts = _mm256_blendv_ps(lowestCosts, neighborCosts, isLower);
+			cells = _mm256_blendv_ps(cells, _mm256_castsi256_ps(_mm256_set1_epi32(FlowFieldCell::PATHABLE | direction)), isLower);
+		}
+
+		// Unreachable cells can still have connections in a directional graph, they stay empty
+		cells = _mm256_andnot_ps(_mm256_cmp_ps(ownCosts, unreachable, _CMP_EQ_OQ), cells);
+
+		// 8 x int32 to 8 bytes: each 128-bit lane ends up with its 4 cells in its lowest 4 bytes
+		const __m256i cells16{ _mm256_packs_epi32(_mm256_castps_si256(cells), _mm256_castps_si256(cells)) };
+		const __m256i cells8{ _mm256_packus_epi16(cells16, cells16) };
+		const int lowCells{ _mm_cvtsi128_si32(_mm256_castsi256_si128(cells8)) };
+		const int highCells{ _mm_cvtsi128_si32(_mm256_extracti128_si256(cells8, 1)) };
+		std::memcpy(pRowCells + col, &lowCells, 4);
+		std::memcpy(pRowCells + col + 4, &highCells, 4);
+	}
+#elif defined(ELITE_DIRECTION_FIELD_SSE2)
+	const __m128 unreachable{ _mm_set1_ps(IntegrationField::UNREACHABLE_COST) };
+	const __m128i goal{ _mm_set1_epi32(FlowFieldCell::PATHABLE | FlowFieldCell::GOAL) };
+	const __m128i zero{ _mm_setzero_si128() };
+
+	for (; col + 4 <= m_NrOfColumns; col += 4)
+	{
+		const float* pCosts{ pRowCosts + col };
+		const __m128 ownCosts{ _mm_loadu_ps(pCosts) };
+
+		int maskBytes{};
+		std::memcpy(&maskBytes, pRowMasks + col, 4);
+		const __m128i masks{ _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(maskBytes), zero), zero) };
+
+		__m128 lowestCosts{ ownCosts };
+		__m128i cells{ goal };
+		for (int direction = 0; direction < m_NrOfDirections; ++direction)
+		{
+			const __m128i bit{ _mm_set1_epi32(1 << direction) };
+			const __m128 hasConnection{ _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(masks, bit), bit)) };
+			const __m128 neighborCosts{ _mm_loadu_ps(pCosts + paddedOffsets[direction]) };
+			const __m128 isLower{ _mm_and_ps(hasConnection, _mm_cmplt_ps(neighborCosts, lowestCosts)) };
+			const __m128i isLowerInt{ _mm_castps_si128(isLower) };
+
+			lowestCosts = _mm_or_ps(_mm_and_ps(isLower, neighborCosts), _mm_andnot_ps(isLower, lowestCosts));
+			cells = _mm_or_si128(_mm_and_si128(isLowerInt, _mm_set1_epi32(FlowFieldCell::PATHABLE | direction)), _mm_andnot_si128(isLowerInt, cells));
+		}
+
+		// Unreachable cells can still have connections in a directional graph, they stay empty
+		cells = _mm_andnot_si128(_mm_castps_si128(_mm_cmpeq_ps(ownCosts, unreachable)), cells);
+
+		const __m128i cells16{ _mm_packs_epi32(cells, cells) };
+		const int packedCells{ _mm_cvtsi128_si32(_mm_packus_epi16(cells16, cells16)) };
+		std::memcpy(pRowCells + col, &packedCells, 4);
+	}
+#endif
+
+	for (; col < m_NrOfColumns; ++col)
+	{
+		const int nodeId{ row * m_NrOfColumns + col };
+		m_Cells[nodeId] = CalculateCell(grid, costs, nodeId);
+	}
+}
+
+void DirectionField::CalculateQuadrantLineOfSight(const DenseGrid& grid, int goalNodeId, int quadrant, int firstColDistance, int firstRowDistance)
+{
+	const int goalCol{ goalNodeId % m_NrOfColumns };
+	const int goalRow{ goalNodeId / m_NrOfColumns };
+	const int stepCol{ quadrant % 2 == 0 ? 1 : -1 };
+	const int stepRow{ quadrant / 2 == 0 ? 1 : -1 };
+
+	// Directions from a cell back towards the goal
+	const int colDirection{ DenseGrid::GetDirection(-stepCol, 0) };
+	const int rowDirection{ DenseGrid::GetDirection(0, -stepRow) };
+	const int colOffset{ -stepCol };
+	const int rowOffset{ -stepRow * m_NrOfColumns };
+
+	for (int row = goalRow + firstRowDistance * stepRow; row >= 0 && row < m_NrOfRows; row += stepRow)
+	{
+		for (int col = goalCol + firstColDistance * stepCol; col >= 0 && col < m_NrOfColumns; col += stepCol)
+		{
+			const int nodeId{ row * m_NrOfColumns + col };
+			uint8_t& cell{ m_Cells[nodeId] };
+
+			bool hasLineOfSight{ FlowFieldCell::IsPathable(cell) };
+			if (nodeId != goalNodeId)
+			{
+				// Only open ground keeps the straight line as cheap as the flow, the straight neighbours also have to be connected
+				hasLineOfSight = hasLineOfSight && grid.GetTerrainType(nodeId) == TerrainType::Ground;
+				if (col != goalCol)
+					hasLineOfSight = hasLineOfSight && grid.HasConnection(nodeId, colDirection) && FlowFieldCell::HasLineOfSight(m_Cells[nodeId + colOffset]);
+				if (row != goalRow)
+					hasLineOfSight = hasLineOfSight && grid.HasConnection(nodeId, rowDirection) && FlowFieldCell::HasLineOfSight(m_Cells[nodeId + rowOffset]);
+				if (col != goalCol && row != goalRow)
+					hasLineOfSight = hasLineOfSight && FlowFieldCell::HasLineOfSight(m_Cells[nodeId + rowOffset + colOffset]);
+			}
+
+			if (hasLineOfSight)
+				cell |= FlowFieldCell::LINE_OF_SIGHT;
+			else
+				cell &= ~FlowFieldCell::LINE_OF_SIGHT;
+		}
+	}
+}
+
+uint8_t DirectionField::CalculateCell(const DenseGrid& grid, const std::vector<float>& costs, int nodeId) const
+{
+	float lowestCost{ costs[nodeId] };
+	if (lowestCost == IntegrationField::UNREACHABLE_COST)
+		return 0;
+
+	// Connections only exist to neighbours inside the grid, so the neighbour ids don't need a bounds check
+	const uint8_t neighborMask{ grid.GetNeighborMask(nodeId) };
+	uint8_t cell{ FlowFieldCell::PATHABLE | FlowFieldCell::GOAL };
+	for (int direction = 0; direction < m_NrOfDirections; ++direction)
+	{
+		if (((neighborMask >> direction) & 1) == 0)
+			continue;
+
+		const float neighborCost{ costs[nodeId + DenseGrid::DIRECTION_OFFSETS[direction][1] * m_NrOfColumns + DenseGrid::DIRECTION_OFFSETS[direction][0]] };
+		if (neighborCost < lowestCost)
+		{
+			lowestCost = neighborCost;
+			cell = FlowFieldCell::PATHABLE | static_cast<uint8_t>(direction);
+		}
+	}
+	return cell;
+}
@@ -0,0 +1,104 @@
+//*=================================================*/
+// EDirectionField.h: encoded flow field of an integration field, one byte per cell with the direction to its cheapest
+// neighbour and a few flags. The full field is generated with SIMD (AVX2 or SSE2, scalar otherwise) over a padded copy of the costs.
+//*=================================================*/
+
+#pragma once
+#include <vector>
+#include <array>
+#include <cstdint>
+#include "../EliteGridGraph/EDenseGrid.h"
+
+namespace Elite
+{
+	class GridGraph;
+
+	// Layout of an encoded flow field cell
+	namespace FlowFieldCell
+	{
+		constexpr uint8_t DIRECTION_MASK{ 0x07 };	// DenseGrid direction to the cheapest neighbour
+		constexpr uint8_t LINE_OF_SIGHT{ 0x08 };	// A straight line to the goal only crosses open ground
+		constexpr uint8_t PATHABLE{ 0x10 };			// The goal can be reached from the cell
+		constexpr uint8_t GOAL{ 0x20 };				// The flow ends in this cell, it has no cheaper neighbour
+
+		constexpr uint8_t GetDirection(uint8_t cell) { return cell & DIRECTION_MASK; }
+		constexpr bool HasLineOfSight(uint8_t cell) { return (cell & LINE_OF_SIGHT) != 0; }
+		constexpr bool IsPathable(uint8_t cell) { return (cell & PATHABLE) != 0; }
+		constexpr bool IsGoal(uint8_t cell) { return (cell & GOAL) != 0; }
+
+		constexpr std::array<Vector2, 256> MakeDecodeTable()
+		{
+			constexpr float diagonal{ 0.70710678f };
+			constexpr Vector2 directionVectors[DenseGrid::NR_OF_DIRECTIONS]
+			{
+				{ 1.f, 0.f }, { 0.f, 1.f }, { -1.f, 0.f }, { 0.f, -1.f },
+				{ diagonal, diagonal }, { -diagonal, diagonal }, { -diagonal, -diagonal }, { diagonal, -diagonal }
+			};
+
+			std::array<Vector2, 256> decodeTable{};
+			for (int cell = 0; cell < 256; ++cell)
+			{
+				if (IsPathable(static_cast<uint8_t>(cell)) && !IsGoal(static_cast<uint8_t>(cell)))
+					decodeTable[cell] = directionVectors[GetDirection(static_cast<uint8_t>(cell))];
+			}
+			return decodeTable;
+		}
+
+		// Unit vector of every cell value, zero where the flow has no direction
+		inline constexpr std::array<Vector2, 256> DECODE_TABLE{ MakeDecodeTable() };
+	}
+
+	class DirectionField final
+	{
+	public:
+		DirectionField() = default;
+		~DirectionField() = default;
+		DirectionField(const DirectionField&) = default;
+		DirectionField(DirectionField&&) = default;
+		DirectionField& operator=(const DirectionField&) = default;
+		DirectionField& operator=(DirectionField&&) = default;
+
+		// Points every reachable cell to its cheapest connected neighbour, ties go to the first direction in DenseGrid order.
+		// Without diagonal connectivity only the 4 straight neighbours are looked at. Clears the line of sight flags.
+		void Calculate(const GridGraph* pGraph, const std::vector<float>& costs, bool isConnectedDiagonally = true);
+		void Calculate(const DenseGrid& grid, const std::vector<float>& costs, bool isConnectedDiagonally = true);
+
+		// Recalculates a single cell with the same connectivity as the last Calculate, e.g. around the cells a repair changed
+		void CalculateAtNode(const GridGraph* pGraph, const std::vector<float>& costs, int nodeId);
+		void CalculateAtNode(const DenseGrid& grid, const std::vector<float>& costs, int nodeId);
+
+		// Flags the cells that can walk straight to the goal. Conservative: a cell only gets it when its neighbours
+		// towards the goal have it, so the shadow of a wall or of expensive terrain is rather too wide than too narrow.
+		void CalculateLineOfSight(const GridGraph* pGraph, int goalNodeId);
+		void CalculateLineOfSight(const DenseGrid& grid, int goalNodeId);
+
+		// Same after an edit, but only sweeps the cells the changed ones can shadow: the cells whose direction, terrain or
+		// connections changed and everything behind them as seen from the goal. An edit close to the goal is still a full pass.
+		void CalculateLineOfSight(const GridGraph* pGraph, int goalNodeId, const std::vector<int>& changedNodeIds);
+		void CalculateLineOfSight(const DenseGrid& grid, int goalNodeId, const std::vector<int>& changedNodeIds);
+
+		// Takes over cells that were calculated earlier for the same graph, e.g. from a cache
+		void Restore(const GridGraph* pGraph, const std::vector<uint8_t>& cells);
+
+		// Every cell of the graph unreachable
+		void Clear(const GridGraph* pGraph);
+
+		const std::vector<uint8_t>& GetCells() const { return m_Cells; }
+		uint8_t GetCell(int nodeId) const { return m_Cells[nodeId]; }
+		Vector2 GetVector(int nodeId) const { return FlowFieldCell::DECODE_TABLE[m_Cells[nodeId]]; }
+
+	private:
+		int m_NrOfColumns{ 0 };
+		int m_NrOfRows{ 0 };
+		int m_NrOfDirections{ DenseGrid::NR_OF_DIRECTIONS };
+
+		// Costs with a border of unreachable cells around them, so the vector loads at the edges stay inside the array
+		std::vector<float> m_PaddedCosts{};
+		std::vector<uint8_t> m_Cells{};
+
+		void PadCosts(const std::vector<float>& costs);
+		void CalculateRow(const DenseGrid& grid, const std::vector<float>& costs, int row);
+		void CalculateQuadrantLineOfSight(const DenseGrid& grid, int goalNodeId, int quadrant, int firstColDistance, int firstRowDistance);
+		uint8_t CalculateCell(const DenseGrid& grid, const std::vector<float>& costs, int nodeId) const;
+	};
+}
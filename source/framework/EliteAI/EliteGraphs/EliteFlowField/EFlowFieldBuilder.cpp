@@ -0,0 +1,181 @@
+#include "stdafx.h"
+#include "EFlowFieldBuilder.h"
+
+#include "../EliteGridGraph/EGridGraph.h"
+
+using namespace Elite;
+
+FlowFieldBuilder::FlowFieldBuilder()
+{
+	m_Worker = std::thread{ &FlowFieldBuilder::RunWorker, this };
+}
+
+FlowFieldBuilder::~FlowFieldBuilder()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_JobAvailable.notify_one();
+	m_Worker.join();
+}
+
+unsigned int FlowFieldBuilder::Request(const GridGraph* pGraph, const std::vector<IntegrationSeed>& seeds, bool isConnectedDiagonally, int lineOfSightGoalNodeId)
+{
+	unsigned int generation{};
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		CopyGrid(pGraph->GetDenseGrid(), *m_pPendingJob);
+		m_pPendingJob->seeds = seeds;
+		m_pPendingJob->isConnectedDiagonally = isConnectedDiagonally;
+		m_pPendingJob->lineOfSightGoalNodeId = lineOfSightGoalNodeId;
+		m_pPendingJob->generation = generation = ++m_RequestedGeneration;
+		m_pPendingJob->isRepair = CanRepair(pGraph->GetDenseGrid(), seeds, isConnectedDiagonally, lineOfSightGoalNodeId, m_pPendingJob->modifiedNodeIds);
+		m_HasPendingJob = true;
+	}
+	m_JobAvailable.notify_one();
+	return generation;
+}
+
+bool FlowFieldBuilder::TryPublish(IntegrationField& integrationField, DirectionField& directionField)
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	if (!m_HasReadyResult)
+		return false;
+
+	m_HasReadyResult = false;
+	if (m_pReadyResult->generation <= m_DiscardedGeneration)
+		return false;
+
+	std::swap(integrationField, m_pReadyResult->integrationField);
+	std::swap(directionField, m_pReadyResult->directionField);
+	m_PublishedGeneration = m_pReadyResult->generation;
+	return true;
+}
+
+void FlowFieldBuilder::Discard()
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_DiscardedGeneration = m_RequestedGeneration;
+	++m_SnapshotEpoch;
+	m_HasPendingJob = false;
+	m_HasReadyResult = false;
+}
+
+unsigned int FlowFieldBuilder::GetRequestedGeneration() const
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	return m_RequestedGeneration;
+}
+
+bool FlowFieldBuilder::IsBusy() const
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	return m_HasPendingJob || m_IsRunning;
+}
+
+void FlowFieldBuilder::CopyGrid(const DenseGrid& grid, Job& job)
+{
+	// The whole grid is about 34 bytes per cell, an edit only has to bring the cells it changed over
+	m_ChangedNodeIds.clear();
+	if (job.snapshotEpoch == m_SnapshotEpoch && job.grid.GetColumns() == grid.GetColumns() && job.grid.GetRows() == grid.GetRows()
+		&& job.grid.GetRevision() <= grid.GetRevision() && grid.GetChangedCells(job.grid.GetRevision(), m_ChangedNodeIds))
+	{
+		job.grid.CopyCells(grid, m_ChangedNodeIds);
+		return;
+	}
+
+	job.grid = grid;
+	job.snapshotEpoch = m_SnapshotEpoch;
+}
+
+bool FlowFieldBuilder::CanRepair(const DenseGrid& grid, const std::vector<IntegrationSeed>& seeds, bool isConnectedDiagonally, int lineOfSightGoalNodeId, std::vector<int>& modifiedNodeIds) const
+{
+	// The job runs after the one the worker took last, so it starts from the fields of that job. Those can be repaired
+	// when they were built for the same goals on an older revision of the same grid.
+	modifiedNodeIds.clear();
+	const Job& lastJob{ *m_pRunningJob };
+	if (!m_HasTakenJob || lastJob.snapshotEpoch != m_SnapshotEpoch || lastJob.grid.GetColumns() != grid.GetColumns() || lastJob.grid.GetRows() != grid.GetRows())
+		return false;
+
+	if (lastJob.isConnectedDiagonally != isConnectedDiagonally || lastJob.lineOfSightGoalNodeId != lineOfSightGoalNodeId)
+		return false;
+
+	if (!std::equal(lastJob.seeds.begin(), lastJob.seeds.end(), seeds.begin(), seeds.end(),
+		[](const IntegrationSeed& lhs, const IntegrationSeed& rhs) { return lhs.nodeId == rhs.nodeId && lhs.initialCost == rhs.initialCost; }))
+		return false;
+
+	return lastJob.grid.GetRevision() <= grid.GetRevision() && grid.GetChangedCells(lastJob.grid.GetRevision(), modifiedNodeIds);
+}
+
+void FlowFieldBuilder::RunWorker()
+{
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	while (true)
+	{
+		m_JobAvailable.wait(lock, [this] { return m_IsStopping || m_HasPendingJob; });
+		if (m_IsStopping)
+			return;
+
+		std::swap(m_pPendingJob, m_pRunningJob);
+		m_HasPendingJob = false;
+		m_HasTakenJob = true;
+		m_IsRunning = true;
+		lock.unlock();
+
+		// Only the worker writes to the running job and the back result, Request only reads the running job
+		const Job& job{ *m_pRunningJob };
+		if (job.isRepair)
+			RepairFields(job);
+		else
+			BuildFields(job);
+
+		Result& result{ *m_pBackResult };
+		result.integrationField = m_WorkerIntegrationField;
+		result.directionField = m_WorkerDirectionField;
+		result.generation = job.generation;
+
+		lock.lock();
+		m_IsRunning = false;
+		if (result.generation > m_DiscardedGeneration)
+		{
+			std::swap(m_pBackResult, m_pReadyResult);
+			m_HasReadyResult = true;
+		}
+	}
+}
+
+void FlowFieldBuilder::BuildFields(const Job& job)
+{
+	m_WorkerIntegrationField.Calculate(job.grid, job.seeds);
+	m_WorkerDirectionField.Calculate(job.grid, m_WorkerIntegrationField.GetCosts(), job.isConnectedDiagonally);
+	if (job.lineOfSightGoalNodeId != invalid_node_id)
+		m_WorkerDirectionField.CalculateLineOfSight(job.grid, job.lineOfSightGoalNodeId);
+}
+
+void FlowFieldBuilder::RepairFields(const Job& job)
+{
+	// Only the costs the edits actually changed are propagated again
+	m_WorkerIntegrationField.Repair(job.grid, job.modifiedNodeIds, m_RepairedNodeIds);
+	m_RepairedNodeIds.insert(m_RepairedNodeIds.end(), job.modifiedNodeIds.begin(), job.modifiedNodeIds.end());
+
+	// A direction only depends on the costs of the node's neighbours
+	m_RecalculatedNodeIds.clear();
+	for (int nodeId : m_RepairedNodeIds)
+	{
+		m_WorkerDirectionField.CalculateAtNode(job.grid, m_WorkerIntegrationField.GetCosts(), nodeId);
+		m_RecalculatedNodeIds.push_back(nodeId);
+		for (int direction = 0; direction < DenseGrid::NR_OF_DIRECTIONS; ++direction)
+		{
+			const int neighborId{ job.grid.GetNeighborId(nodeId, direction) };
+			if (neighborId == invalid_node_id)
+				continue;
+
+			m_WorkerDirectionField.CalculateAtNode(job.grid, m_WorkerIntegrationField.GetCosts(), neighborId);
+			m_RecalculatedNodeIds.push_back(neighborId);
+		}
+	}
+
+	if (job.lineOfSightGoalNodeId != invalid_node_id)
+		m_WorkerDirectionField.CalculateLineOfSight(job.grid, job.lineOfSightGoalNodeId, m_RecalculatedNodeIds);
+}
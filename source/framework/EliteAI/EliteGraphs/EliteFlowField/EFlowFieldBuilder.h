@@ -0,0 +1,107 @@
+//*=================================================*/
+// EFlowFieldBuilder.h: rebuilds the integration and direction field of a grid on a worker thread, so an edit never
+// stalls the frame that made it. The last finished field keeps being used until the main thread publishes the next one.
+//*=================================================*/
+
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include "EIntegrationField.h"
+#include "EDirectionField.h"
+#include "../EliteGridGraph/EDenseGrid.h"
+
+namespace Elite
+{
+	class FlowFieldBuilder final
+	{
+	public:
+		FlowFieldBuilder();
+		~FlowFieldBuilder();
+
+		// Queues a rebuild on a snapshot of the grid, so the graph can be edited again right away. A request that didn't
+		// start yet is replaced by the newer one. Only the cells that changed since the last snapshot are copied, unless the
+		// change log of the grid doesn't go back that far. When only the grid changed since the previous request, the worker
+		// repairs the fields it built last instead of building them again. Returns the generation of the request.
+		unsigned int Request(const GridGraph* pGraph, const std::vector<IntegrationSeed>& seeds, bool isConnectedDiagonally, int lineOfSightGoalNodeId = invalid_node_id);
+
+		// Swaps the newest finished fields with the given ones, the old fields go back to the builder to be reused.
+		// Meant to be called by the thread that reads the fields, between frames. Returns false when nothing new finished.
+		bool TryPublish(IntegrationField& integrationField, DirectionField& directionField);
+
+		// Drops every request made so far, e.g. when the fields were replaced in another way or the grid was rebuilt.
+		// The next request copies the whole grid again.
+		void Discard();
+
+		// A request has landed once the published generation reached the generation Request returned
+		unsigned int GetRequestedGeneration() const;
+		unsigned int GetPublishedGeneration() const { return m_PublishedGeneration; }
+		bool IsBusy() const;
+
+	private:
+		struct Job
+		{
+			DenseGrid grid{ 0, 0, 1.f, 1.f };
+			std::vector<IntegrationSeed> seeds{};
+			bool isConnectedDiagonally{ true };
+			int lineOfSightGoalNodeId{ invalid_node_id };
+			unsigned int generation{ 0 };
+			unsigned int snapshotEpoch{ 0 };
+
+			// Cells that changed since the job the worker took before this one, when its fields can be repaired
+			bool isRepair{ false };
+			std::vector<int> modifiedNodeIds{};
+		};
+
+		struct Result
+		{
+			IntegrationField integrationField{};
+			DirectionField directionField{};
+			unsigned int generation{ 0 };
+		};
+
+		std::thread m_Worker{};
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_JobAvailable{};
+
+		// Pending job, filled in by Request and swapped with the running one by the worker, so the grid snapshots reuse their memory
+		std::unique_ptr<Job> m_pPendingJob{ std::make_unique<Job>() };
+		std::unique_ptr<Job> m_pRunningJob{ std::make_unique<Job>() };
+		bool m_HasPendingJob{ false };
+		bool m_IsRunning{ false };
+
+		// The running job stays around after it finished: it is the job the worker took last, whose fields a new job can repair
+		bool m_HasTakenJob{ false };
+
+		// A snapshot that was taken before the last Discard can belong to another grid and is copied as a whole
+		unsigned int m_SnapshotEpoch{ 1 };
+		std::vector<int> m_ChangedNodeIds{};
+
+		// The worker builds into the back result and swaps it with the ready one when it's done, TryPublish takes the ready one
+		std::unique_ptr<Result> m_pBackResult{ std::make_unique<Result>() };
+		std::unique_ptr<Result> m_pReadyResult{ std::make_unique<Result>() };
+		bool m_HasReadyResult{ false };
+
+		// Only touched by the worker: the fields of the last job, kept to be repaired by the next one. The results get a copy.
+		IntegrationField m_WorkerIntegrationField{};
+		DirectionField m_WorkerDirectionField{};
+		std::vector<int> m_RepairedNodeIds{};
+		std::vector<int> m_RecalculatedNodeIds{};
+
+		unsigned int m_RequestedGeneration{ 0 };
+		unsigned int m_DiscardedGeneration{ 0 };
+		unsigned int m_PublishedGeneration{ 0 };
+		bool m_IsStopping{ false };
+
+		void CopyGrid(const DenseGrid& grid, Job& job);
+		bool CanRepair(const DenseGrid& grid, const std::vector<IntegrationSeed>& seeds, bool isConnectedDiagonally, int lineOfSightGoalNodeId, std::vector<int>& modifiedNodeIds) const;
+		void RunWorker();
+		void BuildFields(const Job& job);
+		void RepairFields(const Job& job);
+
+		FlowFieldBuilder(const FlowFieldBuilder&) = delete;
+		FlowFieldBuilder& operator=(const FlowFieldBuilder&) = delete;
+	};
+}
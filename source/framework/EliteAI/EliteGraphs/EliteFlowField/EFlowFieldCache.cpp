@@ -0,0 +1,92 @@
+#include "stdafx.h"
+#include "EFlowFieldCache.h"
+
+using namespace Elite;
+
+size_t FlowFieldCache::CachedFlowField::GetMemorySize() const
+{
+	return sizeof(CachedFlowField) + costs.capacity() * sizeof(float) + cells.capacity() * sizeof(uint8_t);
+}
+
+FlowFieldCache::FlowFieldCache(size_t memoryBudget)
+	: m_MemoryBudget{ memoryBudget }
+{
+}
+
+const FlowFieldCache::CachedFlowField* FlowFieldCache::Find(int goalNodeId, unsigned int terrainRevision)
+{
+	UpdateTerrainRevision(terrainRevision);
+	if (terrainRevision != m_TerrainRevision)
+		return nullptr;
+
+	const auto it = m_FieldsByGoal.find(goalNodeId);
+	if (it == m_FieldsByGoal.end())
+		return nullptr;
+
+	// Move it to the front without copying the field
+	m_Fields.splice(m_Fields.begin(), m_Fields, it->second);
+	return &m_Fields.front();
+}
+
+void FlowFieldCache::Store(int goalNodeId, unsigned int terrainRevision, const std::vector<float>& costs, const std::vector<uint8_t>& cells)
+{
+	UpdateTerrainRevision(terrainRevision);
+	if (terrainRevision != m_TerrainRevision)
+		return;
+
+	// Replace an older field for the same goal
+	const auto it = m_FieldsByGoal.find(goalNodeId);
+	if (it != m_FieldsByGoal.end())
+	{
+		m_MemoryUsage -= it->second->GetMemorySize();
+		m_Fields.erase(it->second);
+		m_FieldsByGoal.erase(it);
+	}
+
+	CachedFlowField field{ goalNodeId, costs, cells };
+	const size_t memorySize{ field.GetMemorySize() };
+	if (memorySize > m_MemoryBudget)
+		return;
+
+	EvictUntilUsage(m_MemoryBudget - memorySize);
+
+	m_Fields.push_front(std::move(field));
+	m_FieldsByGoal[goalNodeId] = m_Fields.begin();
+	m_MemoryUsage += memorySize;
+}
+
+void FlowFieldCache::Clear()
+{
+	m_Fields.clear();
+	m_FieldsByGoal.clear();
+	m_MemoryUsage = 0;
+	m_TerrainRevision = 0;
+}
+
+void FlowFieldCache::SetMemoryBudget(size_t memoryBudget)
+{
+	m_MemoryBudget = memoryBudget;
+	EvictUntilUsage(m_MemoryBudget);
+}
+
+// The terrain revision only goes up: a newer revision makes every stored field outdated, an older one is outdated itself
+void FlowFieldCache::UpdateTerrainRevision(unsigned int terrainRevision)
+{
+	if (terrainRevision <= m_TerrainRevision && !m_Fields.empty())
+		return;
+
+	m_Fields.clear();
+	m_FieldsByGoal.clear();
+	m_MemoryUsage = 0;
+	m_TerrainRevision = terrainRevision;
+}
+
+void FlowFieldCache::EvictUntilUsage(size_t memoryUsage)
+{
+	while (m_MemoryUsage > memoryUsage && !m_Fields.empty())
+	{
+		m_MemoryUsage -= m_Fields.back().GetMemorySize();
+		m_FieldsByGoal.erase(m_Fields.back().goalNodeId);
+		m_Fields.pop_back();
+	}
+}
@@ -0,0 +1,58 @@
+//*=================================================*/
+// EFlowFieldCache.h: keeps the finished flow fields of recently used goals, so going back to a goal is a lookup
+//*=================================================*/
+
+#pragma once
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+
+namespace Elite
+{
+	class FlowFieldCache final
+	{
+	public:
+		struct CachedFlowField
+		{
+			int goalNodeId;
+			std::vector<float> costs;
+			std::vector<uint8_t> cells;
+
+			size_t GetMemorySize() const;
+		};
+
+		static constexpr size_t DEFAULT_MEMORY_BUDGET{ 16 * 1024 * 1024 };
+
+		explicit FlowFieldCache(size_t memoryBudget = DEFAULT_MEMORY_BUDGET);
+		~FlowFieldCache() = default;
+
+		// Returns the field for the goal if it was stored for this revision of the terrain, nullptr otherwise.
+		// A found field becomes the most recently used one.
+		const CachedFlowField* Find(int goalNodeId, unsigned int terrainRevision);
+
+		// Stores a copy of the field, evicting the least recently used fields until it fits in the memory budget.
+		// Fields of an older terrain revision can't be found anymore and are dropped.
+		void Store(int goalNodeId, unsigned int terrainRevision, const std::vector<float>& costs, const std::vector<uint8_t>& cells);
+
+		// Has to be called when the fields are no longer about the same graph, e.g. after a new grid was made
+		void Clear();
+
+		void SetMemoryBudget(size_t memoryBudget);
+		size_t GetMemoryBudget() const { return m_MemoryBudget; }
+		size_t GetMemoryUsage() const { return m_MemoryUsage; }
+		int GetNrOfFields() const { return static_cast<int>(m_Fields.size()); }
+
+	private:
+		// Most recently used field in front
+		std::list<CachedFlowField> m_Fields{};
+		std::unordered_map<int, std::list<CachedFlowField>::iterator> m_FieldsByGoal{};
+
+		unsigned int m_TerrainRevision{ 0 };
+		size_t m_MemoryBudget;
+		size_t m_MemoryUsage{ 0 };
+
+		void UpdateTerrainRevision(unsigned int terrainRevision);
+		void EvictUntilUsage(size_t memoryUsage);
+	};
+}
@@ -0,0 +1,358 @@
+#include "stdafx.h"
+#include "EIntegrationField.h"
+
+#include "../EliteGridGraph/EGridGraph.h"
+#include "framework/EliteGeometry/EGeometry2DTypes.h"
+#include "framework/EliteGeometry/EGeometry2DUtilities.h"
+
+using namespace Elite;
+
+void IntegrationField::Calculate(const GridGraph* pGraph, int goalNodeId)
+{
+	Calculate(pGraph, std::vector<IntegrationSeed>{ { goalNodeId } });
+}
+
+void IntegrationField::Calculate(const GridGraph* pGraph, const std::vector<IntegrationSeed>& seeds)
+{
+	Calculate(pGraph->GetDenseGrid(), seeds);
+}
+
+void IntegrationField::Calculate(const DenseGrid& grid, const std::vector<IntegrationSeed>& seeds)
+{
+	m_NrOfColumns = grid.GetColumns();
+	m_NrOfRows = grid.GetRows();
+	const size_t nrOfNodes{ static_cast<size_t>(m_NrOfColumns) * m_NrOfRows };
+
+	// All nodes are unvisited
+	m_Costs.assign(nrOfNodes, UNREACHABLE_COST);
+	SetSeeds(seeds);
+
+	if (m_Seeds.empty())
+		return;
+
+	GatherIncomingCosts(grid);
+	PropagateFromSeeds();
+
+	// After a full calculation every node is consistent
+	m_LookaheadCosts = m_Costs;
+	m_IsCostChanged.assign(nrOfNodes, false);
+}
+
+void IntegrationField::Repair(const GridGraph* pGraph, const std::vector<int>& modifiedNodeIds, std::vector<int>& changedCostNodeIds)
+{
+	Repair(pGraph->GetDenseGrid(), modifiedNodeIds, changedCostNodeIds);
+}
+
+void IntegrationField::Repair(const DenseGrid& grid, const std::vector<int>& modifiedNodeIds, std::vector<int>& changedCostNodeIds)
+{
+	changedCostNodeIds.clear();
+	if (m_Seeds.empty())
+		return;
+
+	// Nothing to repair on a different grid, start over
+	if (grid.GetColumns() != m_NrOfColumns || grid.GetRows() != m_NrOfRows)
+	{
+		const std::vector<IntegrationSeed> seeds{ m_Seeds };
+		Calculate(grid, seeds);
+		for (int nodeId = 0; nodeId < static_cast<int>(m_Costs.size()); ++nodeId)
+			changedCostNodeIds.push_back(nodeId);
+		return;
+	}
+
+	// Restored fields only gather their connections once they are repaired
+	if (m_IncomingCosts.size() != m_Costs.size() * NR_OF_DIRECTIONS)
+		GatherIncomingCosts(grid);
+
+	m_RepairQueue.clear();
+	for (int nodeId : modifiedNodeIds)
+	{
+		GatherIncomingCosts(grid, nodeId);
+	}
+
+	// The outgoing connections of the modified nodes and of their neighbours are the only ones that changed
+	for (int nodeId : modifiedNodeIds)
+	{
+		UpdateLookaheadCost(nodeId);
+		for (int direction = 0; direction < NR_OF_DIRECTIONS; ++direction)
+		{
+			const int neighborId{ GetNeighborId(nodeId, direction) };
+			if (neighborId != invalid_node_id)
+				UpdateLookaheadCost(neighborId);
+		}
+	}
+
+	while (!m_RepairQueue.empty())
+	{
+		std::pop_heap(m_RepairQueue.begin(), m_RepairQueue.end(), std::greater<RepairRecord>{});
+		const RepairRecord record{ m_RepairQueue.back() };
+		m_RepairQueue.pop_back();
+
+		const int nodeId{ record.nodeId };
+		float& cost{ m_Costs[nodeId] };
+		const float lookaheadCost{ m_LookaheadCosts[nodeId] };
+
+		// Skip nodes that became consistent or were pushed again with another key
+		if (cost == lookaheadCost || record.key != min(cost, lookaheadCost))
+			continue;
+
+		if (!m_IsCostChanged[nodeId])
+		{
+			m_IsCostChanged[nodeId] = true;
+			changedCostNodeIds.push_back(nodeId);
+		}
+
+		if (cost > lookaheadCost)
+		{
+			// Cheaper than before: settle it
+			cost = lookaheadCost;
+		}
+		else
+		{
+			// More expensive than before: invalidate it and let it be re-evaluated from its neighbours
+			cost = UNREACHABLE_COST;
+			UpdateLookaheadCost(nodeId);
+		}
+
+		// Every node with a connection into this node depends on its cost
+		for (int direction = 0; direction < NR_OF_DIRECTIONS; ++direction)
+		{
+			if (m_IncomingCosts[nodeId * NR_OF_DIRECTIONS + direction] != UNREACHABLE_COST)
+				UpdateLookaheadCost(GetNeighborId(nodeId, direction));
+		}
+	}
+
+	for (int nodeId : changedCostNodeIds)
+		m_IsCostChanged[nodeId] = false;
+}
+
+void IntegrationField::AddSeedsInRect(const GridGraph* pGraph, const Vector2& bottomLeft, const Vector2& topRight, float initialCost, std::vector<IntegrationSeed>& seeds)
+{
+	for (int nodeId = 0; nodeId < pGraph->GetColumns() * pGraph->GetRows(); ++nodeId)
+	{
+		const Vector2 position{ pGraph->GetNodePos(nodeId) };
+		if (position.x >= bottomLeft.x && position.x <= topRight.x && position.y >= bottomLeft.y && position.y <= topRight.y)
+			seeds.push_back({ nodeId, initialCost });
+	}
+}
+
+void IntegrationField::AddSeedsInPolygon(const GridGraph* pGraph, const Polygon& polygon, float initialCost, std::vector<IntegrationSeed>& seeds)
+{
+	const Vector2 bottomLeft{ polygon.GetPosVertMinXPos(), polygon.GetPosVertMinYPos() };
+	const Vector2 topRight{ polygon.GetPosVertMaxXPos(), polygon.GetPosVertMaxYPos() };
+
+	for (int nodeId = 0; nodeId < pGraph->GetColumns() * pGraph->GetRows(); ++nodeId)
+	{
+		const Vector2 position{ pGraph->GetNodePos(nodeId) };
+		if (position.x < bottomLeft.x || position.x > topRight.x || position.y < bottomLeft.y || position.y > topRight.y)
+			continue;
+
+		if (IsPointInPolygon(position, polygon.GetPoints()))
+			seeds.push_back({ nodeId, initialCost });
+	}
+}
+
+void IntegrationField::Restore(const GridGraph* pGraph, const std::vector<IntegrationSeed>& seeds, const std::vector<float>& costs)
+{
+	m_NrOfColumns = pGraph->GetColumns();
+	m_NrOfRows = pGraph->GetRows();
+	SetSeeds(seeds);
+
+	m_Costs = costs;
+	m_LookaheadCosts = costs;
+	m_IsCostChanged.assign(costs.size(), false);
+	m_IncomingCosts.clear();
+}
+
+float IntegrationField::GetHighestReachableCost() const
+{
+	float highestCost{ 0.f };
+	for (float cost : m_Costs)
+	{
+		if (cost != UNREACHABLE_COST && cost > highestCost)
+			highestCost = cost;
+	}
+	return highestCost;
+}
+
+// Flattens the connections of the dense grid into a per-node array of incoming costs,
+// so the wavefront only has to walk contiguous memory
+void IntegrationField::GatherIncomingCosts(const DenseGrid& grid)
+{
+	m_IncomingCosts.assign(m_Costs.size() * NR_OF_DIRECTIONS, UNREACHABLE_COST);
+	m_LowestConnectionCost = FLT_MAX;
+	m_HighestConnectionCost = 0.f;
+
+	for (int fromId = 0; fromId < static_cast<int>(m_Costs.size()); ++fromId)
+	{
+		const uint8_t neighborMask{ grid.GetNeighborMask(fromId) };
+		for (int direction = 0; direction < NR_OF_DIRECTIONS; ++direction)
+		{
+			// Connections only exist to neighbours inside the grid
+			if (((neighborMask >> direction) & 1) == 0)
+				continue;
+
+			const int toId{ fromId + DenseGrid::DIRECTION_OFFSETS[direction][1] * m_NrOfColumns + DenseGrid::DIRECTION_OFFSETS[direction][0] };
+			const float cost{ grid.GetConnectionCost(fromId, direction) };
+			m_IncomingCosts[toId * NR_OF_DIRECTIONS + DenseGrid::OPPOSITE_DIRECTIONS[direction]] = cost;
+			m_LowestConnectionCost = min(m_LowestConnectionCost, cost);
+			m_HighestConnectionCost = max(m_HighestConnectionCost, cost);
+		}
+	}
+}
+
+// Refreshes the incoming costs of every connection from or to the node
+void IntegrationField::GatherIncomingCosts(const DenseGrid& grid, int nodeId)
+{
+	for (int direction = 0; direction < NR_OF_DIRECTIONS; ++direction)
+	{
+		const int neighborId{ GetNeighborId(nodeId, direction) };
+		if (neighborId == invalid_node_id)
+			continue;
+
+		const int oppositeDirection{ DenseGrid::OPPOSITE_DIRECTIONS[direction] };
+		m_IncomingCosts[nodeId * NR_OF_DIRECTIONS + direction] = grid.HasConnection(neighborId, oppositeDirection) ? grid.GetConnectionCost(neighborId, oppositeDirection) : UNREACHABLE_COST;
+		m_IncomingCosts[neighborId * NR_OF_DIRECTIONS + oppositeDirection] = grid.HasConnection(nodeId, direction) ? grid.GetConnectionCost(nodeId, direction) : UNREACHABLE_COST;
+	}
+}
+
+void IntegrationField::SetSeeds(const std::vector<IntegrationSeed>& seeds)
+{
+	const int nrOfNodes{ m_NrOfColumns * m_NrOfRows };
+	m_Seeds.clear();
+	for (const IntegrationSeed& seed : seeds)
+	{
+		if (seed.nodeId >= 0 && seed.nodeId < nrOfNodes)
+			m_Seeds.push_back({ seed.nodeId, max(seed.initialCost, 0.f) });
+	}
+
+	// Keep the cheapest initial cost of nodes that were given more than once
+	std::sort(m_Seeds.begin(), m_Seeds.end(), [](const IntegrationSeed& lhs, const IntegrationSeed& rhs) {
+		return lhs.nodeId != rhs.nodeId ? lhs.nodeId < rhs.nodeId : lhs.initialCost < rhs.initialCost; });
+	m_Seeds.erase(std::unique(m_Seeds.begin(), m_Seeds.end(), [](const IntegrationSeed& lhs, const IntegrationSeed& rhs) { return lhs.nodeId == rhs.nodeId; }), m_Seeds.end());
+
+	m_SeedCosts.assign(static_cast<size_t>(m_NrOfColumns) * m_NrOfRows, UNREACHABLE_COST);
+	for (const IntegrationSeed& seed : m_Seeds)
+		m_SeedCosts[seed.nodeId] = seed.initialCost;
+
+	std::stable_sort(m_Seeds.begin(), m_Seeds.end(), [](const IntegrationSeed& lhs, const IntegrationSeed& rhs) { return lhs.initialCost < rhs.initialCost; });
+}
+
+// Dijkstra from the seeds outwards over the incoming connections.
+// The open list is a ring of buckets that are each as wide as the cheapest connection: a node popped from
+// the current bucket can't be improved by any other node in that bucket, so every node is settled once
+// and no heap is needed. Seeds only join once the wavefront reaches their initial cost, so expensive
+// seeds don't have to fit in the ring.
+void IntegrationField::PropagateFromSeeds()
+{
+	if (m_LowestConnectionCost == FLT_MAX)
+	{
+		// No connections at all, only the seeds are reachable
+		for (const IntegrationSeed& seed : m_Seeds)
+			m_Costs[seed.nodeId] = seed.initialCost;
+		return;
+	}
+
+	const float bucketWidth{ max(m_LowestConnectionCost, 0.001f) };
+	const size_t nrOfBuckets{ static_cast<size_t>(m_HighestConnectionCost / bucketWidth) + 2 };
+	if (m_Buckets.size() < nrOfBuckets)
+		m_Buckets.resize(nrOfBuckets);
+	for (auto& bucket : m_Buckets)
+		bucket.clear();
+
+	size_t nrOfOpenNodes{ 0 };
+	size_t nextSeedIdx{ 0 };
+
+	for (size_t bucketIdx = 0; nrOfOpenNodes > 0 || nextSeedIdx < m_Seeds.size(); ++bucketIdx)
+	{
+		// Nothing to expand until the next seed joins, skip the empty buckets in between
+		if (nrOfOpenNodes == 0)
+			bucketIdx = max(bucketIdx, static_cast<size_t>(m_Seeds[nextSeedIdx].initialCost / bucketWidth));
+
+		for (; nextSeedIdx < m_Seeds.size() && static_cast<size_t>(m_Seeds[nextSeedIdx].initialCost / bucketWidth) <= bucketIdx; ++nextSeedIdx)
+		{
+			const IntegrationSeed& seed{ m_Seeds[nextSeedIdx] };
+			if (seed.initialCost < m_Costs[seed.nodeId])
+			{
+				m_Costs[seed.nodeId] = seed.initialCost;
+				m_Buckets[bucketIdx % nrOfBuckets].push_back(seed.nodeId);
+				++nrOfOpenNodes;
+			}
+		}
+
+		auto& bucket = m_Buckets[bucketIdx % nrOfBuckets];
+
+		// The bucket can grow while we process it, so don't use iterators here
+		for (size_t openIdx = 0; openIdx < bucket.size(); ++openIdx)
+		{
+			--nrOfOpenNodes;
+			const int nodeId{ bucket[openIdx] };
+			const float nodeCost{ m_Costs[nodeId] };
+
+			// Skip records that were pushed again with a lower cost
+			if (static_cast<size_t>(nodeCost / bucketWidth) != bucketIdx)
+				continue;
+
+			const int col{ nodeId % m_NrOfColumns };
+			const int row{ nodeId / m_NrOfColumns };
+			const float* pIncomingCosts{ &m_IncomingCosts[nodeId * NR_OF_DIRECTIONS] };
+
+			for (int direction = 0; direction < NR_OF_DIRECTIONS; ++direction)
+			{
+				if (pIncomingCosts[direction] == UNREACHABLE_COST)
+					continue;
+
+				const int neighborCol{ col + DenseGrid::DIRECTION_OFFSETS[direction][0] };
+				const int neighborRow{ row + DenseGrid::DIRECTION_OFFSETS[direction][1] };
+				if (neighborCol < 0 || neighborCol >= m_NrOfColumns || neighborRow < 0 || neighborRow >= m_NrOfRows)
+					continue;
+
+				const int neighborId{ neighborRow * m_NrOfColumns + neighborCol };
+				const float newCost{ nodeCost + pIncomingCosts[direction] };
+				if (newCost < m_Costs[neighborId])
+				{
+					m_Costs[neighborId] = newCost;
+					m_Buckets[static_cast<size_t>(newCost / bucketWidth) % nrOfBuckets].push_back(neighborId);
+					++nrOfOpenNodes;
+				}
+			}
+		}
+		bucket.clear();
+	}
+}
+
+// Cheapest cost to the goal through one of the outgoing connections of the node (rhs in LPA*)
+void IntegrationField::UpdateLookaheadCost(int nodeId)
+{
+	// Seeds can always stop at their initial cost
+	float lookaheadCost{ m_SeedCosts[nodeId] };
+	for (int direction = 0; direction < NR_OF_DIRECTIONS; ++direction)
+	{
+		const int neighborId{ GetNeighborId(nodeId, direction) };
+		if (neighborId == invalid_node_id || m_Costs[neighborId] == UNREACHABLE_COST)
+			continue;
+
+		const float connectionCost{ m_IncomingCosts[neighborId * NR_OF_DIRECTIONS + DenseGrid::OPPOSITE_DIRECTIONS[direction]] };
+		if (connectionCost != UNREACHABLE_COST)
+			lookaheadCost = min(lookaheadCost, m_Costs[neighborId] + connectionCost);
+	}
+
+	m_LookaheadCosts[nodeId] = lookaheadCost;
+	if (m_Costs[nodeId] != lookaheadCost)
+		PushRepairRecord(nodeId);
+}
+
+void IntegrationField::PushRepairRecord(int nodeId)
+{
+	m_RepairQueue.push_back({ min(m_Costs[nodeId], m_LookaheadCosts[nodeId]), nodeId });
+	std::push_heap(m_RepairQueue.begin(), m_RepairQueue.end(), std::greater<RepairRecord>{});
+}
+
+int IntegrationField::GetNeighborId(int nodeId, int direction) const
+{
+	const int neighborCol{ nodeId % m_NrOfColumns + DenseGrid::DIRECTION_OFFSETS[direction][0] };
+	const int neighborRow{ nodeId / m_NrOfColumns + DenseGrid::DIRECTION_OFFSETS[direction][1] };
+	if (neighborCol < 0 || neighborCol >= m_NrOfColumns || neighborRow < 0 || neighborRow >= m_NrOfRows)
+		return invalid_node_id;
+
+	return neighborRow * m_NrOfColumns + neighborCol;
+}
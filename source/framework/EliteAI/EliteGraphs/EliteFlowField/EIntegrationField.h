@@ -0,0 +1,106 @@
+//*=================================================*/
+// EIntegrationField.h: cost-to-goal field over a GridGraph, built with a single reverse wavefront (Dijkstra) pass from one or more goals
+//*=================================================*/
+
+#pragma once
+#include <vector>
+#include <cfloat>
+#include "../EliteGraph/EGraphEnums.h"
+#include "../EliteGridGraph/EDenseGrid.h"
+
+namespace Elite
+{
+	class GridGraph;
+	class Polygon;
+
+	// Goal cell of an integration field. A seed with an initial cost is a less attractive goal than one without,
+	// negative initial costs are treated as 0.
+	struct IntegrationSeed
+	{
+		int nodeId;
+		float initialCost{ 0.f };
+	};
+
+	class IntegrationField final
+	{
+	public:
+		IntegrationField() = default;
+		~IntegrationField() = default;
+		IntegrationField(const IntegrationField&) = default;
+		IntegrationField(IntegrationField&&) = default;
+		IntegrationField& operator=(const IntegrationField&) = default;
+		IntegrationField& operator=(IntegrationField&&) = default;
+
+		// Value stored for cells that can't reach the goal (walls, isolated terrain, ...)
+		static constexpr float UNREACHABLE_COST{ FLT_MAX };
+
+		// Fills in the cheapest cost from every node of the graph to the goal node, using the connection costs of the graph
+		void Calculate(const GridGraph* pGraph, int goalNodeId);
+
+		// Same for a set of goals: every node gets the cost to its cheapest goal, including the initial cost of that goal
+		void Calculate(const GridGraph* pGraph, const std::vector<IntegrationSeed>& seeds);
+
+		// Same on the dense grid alone, e.g. on a snapshot of the graph that is taken to another thread
+		void Calculate(const DenseGrid& grid, const std::vector<IntegrationSeed>& seeds);
+
+		// Helpers to turn a goal region into seeds: every node whose center is inside the region becomes a seed
+		static void AddSeedsInRect(const GridGraph* pGraph, const Vector2& bottomLeft, const Vector2& topRight, float initialCost, std::vector<IntegrationSeed>& seeds);
+		static void AddSeedsInPolygon(const GridGraph* pGraph, const Polygon& polygon, float initialCost, std::vector<IntegrationSeed>& seeds);
+
+		// Brings the field up to date after the connections of the given nodes changed (walls, terrain, ...), in the style of LPA*:
+		// only the nodes whose cost actually changes are re-propagated. Those nodes are written to changedCostNodeIds.
+		void Repair(const GridGraph* pGraph, const std::vector<int>& modifiedNodeIds, std::vector<int>& changedCostNodeIds);
+		void Repair(const DenseGrid& grid, const std::vector<int>& modifiedNodeIds, std::vector<int>& changedCostNodeIds);
+
+		// Takes over costs that were calculated earlier for the same goal on the same graph, e.g. from a cache
+		void Restore(const GridGraph* pGraph, const std::vector<IntegrationSeed>& seeds, const std::vector<float>& costs);
+
+		const std::vector<float>& GetCosts() const { return m_Costs; }
+		float GetCost(int nodeId) const { return m_Costs[nodeId]; }
+		bool IsReachable(int nodeId) const { return m_Costs[nodeId] != UNREACHABLE_COST; }
+		const std::vector<IntegrationSeed>& GetSeeds() const { return m_Seeds; }
+		bool HasSeeds() const { return !m_Seeds.empty(); }
+		float GetHighestReachableCost() const;
+
+	private:
+		// Directions are the ones of the dense grid: 4 straight directions followed by 4 diagonal directions
+		static constexpr int NR_OF_DIRECTIONS{ DenseGrid::NR_OF_DIRECTIONS };
+
+		std::vector<float> m_Costs{};
+
+		// Valid seeds sorted on their initial cost, and the initial cost of every node (UNREACHABLE_COST for non-seeds)
+		std::vector<IntegrationSeed> m_Seeds{};
+		std::vector<float> m_SeedCosts{};
+		int m_NrOfColumns{ 0 };
+		int m_NrOfRows{ 0 };
+
+		// Cost of the connection from the neighbour in each direction to the node, UNREACHABLE_COST when there is none
+		std::vector<float> m_IncomingCosts{};
+		float m_LowestConnectionCost{ 1.f };
+		float m_HighestConnectionCost{ 1.f };
+
+		// Bucketed open list, reused between calculations to avoid reallocating it every time
+		std::vector<std::vector<int>> m_Buckets{};
+
+		// Repair data: one-step lookahead cost of every node (rhs in LPA*) and the queue of inconsistent nodes
+		struct RepairRecord
+		{
+			float key;
+			int nodeId;
+
+			bool operator>(const RepairRecord& other) const { return key > other.key; }
+		};
+		std::vector<float> m_LookaheadCosts{};
+		std::vector<RepairRecord> m_RepairQueue{};
+		std::vector<bool> m_IsCostChanged{};
+
+		void GatherIncomingCosts(const DenseGrid& grid);
+		void GatherIncomingCosts(const DenseGrid& grid, int nodeId);
+		void SetSeeds(const std::vector<IntegrationSeed>& seeds);
+		void PropagateFromSeeds();
+
+		void UpdateLookaheadCost(int nodeId);
+		void PushRepairRecord(int nodeId);
+		int GetNeighborId(int nodeId, int direction) const;
+	};
+}
@@ -0,0 +1,477 @@
+#include "stdafx.h"
+#include "ESectorFlowField.h"
+
+#include "../EliteGridGraph/EGridGraph.h"
+
+using namespace Elite;
+
+void SectorFlowField::Build(const GridGraph* pGraph, int sectorSize)
+{
+	m_NrOfColumns = pGraph->GetColumns();
+	m_NrOfRows = pGraph->GetRows();
+	m_SectorSize = max(sectorSize, 1);
+	m_NrOfSectorColumns = (m_NrOfColumns + m_SectorSize - 1) / m_SectorSize;
+	const int nrOfSectorRows{ (m_NrOfRows + m_SectorSize - 1) / m_SectorSize };
+
+	m_Sectors.clear();
+	m_Portals.clear();
+	m_Windows.clear();
+	m_PortalIds.clear();
+
+	for (int sectorRow = 0; sectorRow < nrOfSectorRows; ++sectorRow)
+	{
+		for (int sectorCol = 0; sectorCol < m_NrOfSectorColumns; ++sectorCol)
+		{
+			const int firstColumn{ sectorCol * m_SectorSize };
+			const int firstRow{ sectorRow * m_SectorSize };
+			m_Sectors.push_back({ firstColumn, firstRow, min(m_SectorSize, m_NrOfColumns - firstColumn), min(m_SectorSize, m_NrOfRows - firstRow), {}, {} });
+		}
+	}
+
+	// Portals on the borders between neighbouring sectors
+	for (int sectorId = 0; sectorId < static_cast<int>(m_Sectors.size()); ++sectorId)
+	{
+		if (sectorId % m_NrOfSectorColumns + 1 < m_NrOfSectorColumns)
+			AddWindows(pGraph, sectorId, sectorId + 1, true);
+		if (sectorId / m_NrOfSectorColumns + 1 < nrOfSectorRows)
+			AddWindows(pGraph, sectorId, sectorId + m_NrOfSectorColumns, false);
+	}
+
+	// Connect the portals of every sector with each other through the inside of the sector
+	for (int sectorId = 0; sectorId < static_cast<int>(m_Sectors.size()); ++sectorId)
+	{
+		const Sector& sector{ m_Sectors[sectorId] };
+		for (int portalIdx : sector.portals)
+		{
+			ClearLocalSearch();
+			m_LocalCosts[GetLocalIndex(sector, m_Portals[portalIdx].nodeId)] = 0.f;
+			PropagateInSector(pGraph, sectorId);
+
+			for (int otherPortalIdx : sector.portals)
+			{
+				const float cost{ m_LocalCosts[GetLocalIndex(sector, m_Portals[otherPortalIdx].nodeId)] };
+				if (otherPortalIdx != portalIdx && cost != UNREACHABLE_COST)
+					m_Portals[portalIdx].incomingConnections.push_back({ otherPortalIdx, cost });
+			}
+		}
+	}
+
+	m_GoalNodeId = invalid_node_id;
+	m_SectorFieldIds.assign(m_Sectors.size(), invalid_node_id);
+	m_ActiveSectorIds.clear();
+}
+
+void SectorFlowField::Calculate(const GridGraph* pGraph, int goalNodeId, const std::vector<int>& startNodeIds)
+{
+	for (int sectorId : m_ActiveSectorIds)
+		m_SectorFieldIds[sectorId] = invalid_node_id;
+	m_ActiveSectorIds.clear();
+
+	m_GoalNodeId = goalNodeId;
+	if (m_Sectors.empty() || !pGraph->IsNodeValid(goalNodeId))
+	{
+		m_GoalNodeId = invalid_node_id;
+		return;
+	}
+
+	SearchPortals(pGraph);
+
+	ActivateSector(GetSectorId(goalNodeId));
+	ActivateRoutes(pGraph, startNodeIds);
+	BuildSectorFields(pGraph);
+}
+
+Vector2 SectorFlowField::GetDirection(int nodeId) const
+{
+	if (m_GoalNodeId == invalid_node_id || nodeId < 0 || nodeId >= m_NrOfColumns * m_NrOfRows)
+		return Vector2{};
+
+	const int sectorId{ GetSectorId(nodeId) };
+	const int fieldId{ m_SectorFieldIds[sectorId] };
+	if (fieldId == invalid_node_id)
+		return Vector2{};
+
+	return m_SectorFields[fieldId].directions[GetLocalIndex(m_Sectors[sectorId], nodeId)];
+}
+
+float SectorFlowField::GetCost(int nodeId) const
+{
+	if (m_GoalNodeId == invalid_node_id || nodeId < 0 || nodeId >= m_NrOfColumns * m_NrOfRows)
+		return UNREACHABLE_COST;
+
+	const int sectorId{ GetSectorId(nodeId) };
+	const int fieldId{ m_SectorFieldIds[sectorId] };
+	if (fieldId == invalid_node_id)
+		return UNREACHABLE_COST;
+
+	return m_SectorFields[fieldId].costs[GetLocalIndex(m_Sectors[sectorId], nodeId)];
+}
+
+int SectorFlowField::GetSectorId(int nodeId) const
+{
+	const int col{ nodeId % m_NrOfColumns };
+	const int row{ nodeId / m_NrOfColumns };
+	return (row / m_SectorSize) * m_NrOfSectorColumns + col / m_SectorSize;
+}
+
+// Splits the shared border of two sectors into windows: runs of neighbouring cells that are connected across the border.
+// Only straight connections are used to cross a border.
+void SectorFlowField::AddWindows(const GridGraph* pGraph, int sectorId, int otherSectorId, bool isVertical)
+{
+	const DenseGrid& grid{ pGraph->GetDenseGrid() };
+	const Sector& sector{ m_Sectors[sectorId] };
+	const int borderLength{ isVertical ? sector.nrOfRows : sector.nrOfColumns };
+
+	std::vector<Crossing> crossings{};
+	for (int side = 0; side < 2; ++side)
+	{
+		const int fromSectorId{ side == 0 ? sectorId : otherSectorId };
+		const int toSectorId{ side == 0 ? otherSectorId : sectorId };
+		// Straight direction across the border: +col/+row from this sector, -col/-row back into it
+		const int direction{ (isVertical ? 0 : 1) + side * 2 };
+
+		for (int borderIdx = 0; borderIdx < borderLength; ++borderIdx)
+		{
+			const int col{ isVertical ? sector.firstColumn + sector.nrOfColumns - 1 : sector.firstColumn + borderIdx };
+			const int row{ isVertical ? sector.firstRow + borderIdx : sector.firstRow + sector.nrOfRows - 1 };
+			const int nodeId{ row * m_NrOfColumns + col };
+			const int otherNodeId{ isVertical ? nodeId + 1 : nodeId + m_NrOfColumns };
+
+			const int fromNodeId{ side == 0 ? nodeId : otherNodeId };
+			const int toNodeId{ side == 0 ? otherNodeId : nodeId };
+
+			if (grid.HasConnection(fromNodeId, direction))
+				crossings.push_back({ fromNodeId, toNodeId, grid.GetConnectionCost(fromNodeId, direction) });
+			else if (!crossings.empty())
+				AddWindow(fromSectorId, toSectorId, crossings);
+		}
+
+		if (!crossings.empty())
+			AddWindow(fromSectorId, toSectorId, crossings);
+	}
+}
+
+void SectorFlowField::AddWindow(int fromSectorId, int toSectorId, std::vector<Crossing>& crossings)
+{
+	const Crossing& middleCrossing{ crossings[crossings.size() / 2] };
+	const int fromPortalIdx{ GetOrAddPortal(middleCrossing.fromNodeId) };
+	const int toPortalIdx{ GetOrAddPortal(middleCrossing.toNodeId) };
+	m_Portals[toPortalIdx].incomingConnections.push_back({ fromPortalIdx, middleCrossing.cost });
+
+	m_Sectors[fromSectorId].exitWindows.push_back(static_cast<int>(m_Windows.size()));
+	m_Windows.push_back({ toSectorId, toPortalIdx, std::move(crossings) });
+	crossings.clear();
+}
+
+int SectorFlowField::GetOrAddPortal(int nodeId)
+{
+	const auto it = m_PortalIds.find(nodeId);
+	if (it != m_PortalIds.end())
+		return it->second;
+
+	const int portalIdx{ static_cast<int>(m_Portals.size()) };
+	const int sectorId{ GetSectorId(nodeId) };
+	m_Portals.push_back({ nodeId, sectorId, {} });
+	m_Sectors[sectorId].portals.push_back(portalIdx);
+	m_PortalIds[nodeId] = portalIdx;
+	return portalIdx;
+}
+
+// Dijkstra over the portal graph, from the goal outwards
+void SectorFlowField::SearchPortals(const GridGraph* pGraph)
+{
+	const int goalSectorId{ GetSectorId(m_GoalNodeId) };
+	const Sector& goalSector{ m_Sectors[goalSectorId] };
+
+	// The portals of the goal sector are connected to the goal through the inside of the sector
+	ClearLocalSearch();
+	m_LocalCosts[GetLocalIndex(goalSector, m_GoalNodeId)] = 0.f;
+	PropagateInSector(pGraph, goalSectorId);
+
+	m_PortalCosts.assign(m_Portals.size(), UNREACHABLE_COST);
+	m_NextPortals.assign(m_Portals.size(), invalid_node_id);
+	m_OpenList.clear();
+
+	for (int portalIdx : goalSector.portals)
+	{
+		const float cost{ m_LocalCosts[GetLocalIndex(goalSector, m_Portals[portalIdx].nodeId)] };
+		if (cost == UNREACHABLE_COST)
+			continue;
+
+		m_PortalCosts[portalIdx] = cost;
+		m_OpenList.push_back({ cost, portalIdx });
+	}
+	std::make_heap(m_OpenList.begin(), m_OpenList.end(), std::greater<std::pair<float, int>>{});
+
+	while (!m_OpenList.empty())
+	{
+		std::pop_heap(m_OpenList.begin(), m_OpenList.end(), std::greater<std::pair<float, int>>{});
+		const auto [cost, portalIdx] = m_OpenList.back();
+		m_OpenList.pop_back();
+
+		if (cost != m_PortalCosts[portalIdx])
+			continue;
+
+		for (const PortalConnection& connection : m_Portals[portalIdx].incomingConnections)
+		{
+			const float newCost{ cost + connection.cost };
+			if (newCost < m_PortalCosts[connection.portalIdx])
+			{
+				m_PortalCosts[connection.portalIdx] = newCost;
+				m_NextPortals[connection.portalIdx] = portalIdx;
+				m_OpenList.push_back({ newCost, connection.portalIdx });
+				std::push_heap(m_OpenList.begin(), m_OpenList.end(), std::greater<std::pair<float, int>>{});
+			}
+		}
+	}
+}
+
+// Activates the sectors on the way from every start node to the goal.
+// The start sector decides through which window it is left, from there on the portal route is followed.
+void SectorFlowField::ActivateRoutes(const GridGraph* pGraph, const std::vector<int>& startNodeIds)
+{
+	m_StartNodeIds.clear();
+	for (int startNodeId : startNodeIds)
+	{
+		if (pGraph->IsNodeValid(startNodeId))
+			m_StartNodeIds.push_back(startNodeId);
+	}
+
+	// Group the start nodes per sector, so every start sector is only searched once
+	std::sort(m_StartNodeIds.begin(), m_StartNodeIds.end(), [this](int lhs, int rhs) { return GetSectorId(lhs) < GetSectorId(rhs); });
+	m_IsPortalOnRoute.assign(m_Portals.size(), false);
+
+	int searchedSectorId{ invalid_node_id };
+	for (int startNodeId : m_StartNodeIds)
+	{
+		const int sectorId{ GetSectorId(startNodeId) };
+		if (sectorId != searchedSectorId)
+		{
+			SeedSectorFromPortals(sectorId);
+			PropagateInSector(pGraph, sectorId);
+			searchedSectorId = sectorId;
+		}
+
+		const int localIdx{ GetLocalIndex(m_Sectors[sectorId], startNodeId) };
+		if (m_LocalCosts[localIdx] == UNREACHABLE_COST)
+			continue;
+
+		ActivateSector(sectorId);
+
+		const int windowIdx{ m_LocalOrigins[localIdx] };
+		if (windowIdx == invalid_node_id)
+			continue; // Leads straight to the goal
+
+		for (int portalIdx = m_Windows[windowIdx].toPortalIdx; portalIdx != invalid_node_id && !m_IsPortalOnRoute[portalIdx]; portalIdx = m_NextPortals[portalIdx])
+		{
+			m_IsPortalOnRoute[portalIdx] = true;
+			ActivateSector(m_Portals[portalIdx].sectorId);
+		}
+	}
+}
+
+void SectorFlowField::ActivateSector(int sectorId)
+{
+	if (IsSectorActive(sectorId))
+		return;
+
+	m_SectorFieldIds[sectorId] = static_cast<int>(m_ActiveSectorIds.size());
+	m_ActiveSectorIds.push_back(sectorId);
+
+	if (m_SectorFields.size() < m_ActiveSectorIds.size())
+		m_SectorFields.emplace_back();
+}
+
+// The portal costs are only estimates for the cells next to the portal, so the local fields are seeded with the costs of
+// the neighbouring fields instead. Those have to be built first: the sectors are built from the goal outwards, ordered by
+// the cheapest portal they have on a route. A cell can then only lead to a cell that is cheaper, so agents can't go in circles.
+void SectorFlowField::BuildSectorFields(const GridGraph* pGraph)
+{
+	const int goalSectorId{ GetSectorId(m_GoalNodeId) };
+
+	m_SectorOrderKeys.assign(m_Sectors.size(), UNREACHABLE_COST);
+	for (int portalIdx = 0; portalIdx < static_cast<int>(m_Portals.size()); ++portalIdx)
+	{
+		float& key{ m_SectorOrderKeys[m_Portals[portalIdx].sectorId] };
+		if (m_IsPortalOnRoute[portalIdx])
+			key = min(key, m_PortalCosts[portalIdx]);
+	}
+	m_SectorOrderKeys[goalSectorId] = -1.f;
+
+	std::stable_sort(m_ActiveSectorIds.begin(), m_ActiveSectorIds.end(), [this](int lhs, int rhs) { return m_SectorOrderKeys[lhs] < m_SectorOrderKeys[rhs]; });
+	for (int fieldId = 0; fieldId < static_cast<int>(m_ActiveSectorIds.size()); ++fieldId)
+		m_SectorFieldIds[m_ActiveSectorIds[fieldId]] = fieldId;
+
+	for (int fieldId = 0; fieldId < static_cast<int>(m_ActiveSectorIds.size()); ++fieldId)
+		BuildSectorField(pGraph, m_ActiveSectorIds[fieldId], fieldId);
+
+	// Sectors that lead into a sector that was built after them missed those exits, build them again now every field exists.
+	// Costs only go down by adding exits, so the fields that were seeded from the old costs still lead to cheaper cells.
+	const int nrOfFields{ static_cast<int>(m_ActiveSectorIds.size()) };
+	for (int fieldId = 0; fieldId < nrOfFields; ++fieldId)
+	{
+		const int sectorId{ m_ActiveSectorIds[fieldId] };
+		const bool hasMissedExits{ std::any_of(m_Sectors[sectorId].exitWindows.begin(), m_Sectors[sectorId].exitWindows.end(),
+			[this, fieldId](int windowIdx) { return m_SectorFieldIds[m_Windows[windowIdx].toSectorId] > fieldId; }) };
+
+		if (hasMissedExits)
+			BuildSectorField(pGraph, sectorId, nrOfFields);
+	}
+}
+
+void SectorFlowField::BuildSectorField(const GridGraph* pGraph, int sectorId, int nrOfBuiltFields)
+{
+	SeedSectorFromFields(sectorId, nrOfBuiltFields);
+	PropagateInSector(pGraph, sectorId);
+
+	const Sector& sector{ m_Sectors[sectorId] };
+	SectorField& field{ m_SectorFields[m_SectorFieldIds[sectorId]] };
+	field.costs = m_LocalCosts;
+	field.directions.assign(m_LocalCosts.size(), Vector2{});
+
+	for (int row = sector.firstRow; row < sector.firstRow + sector.nrOfRows; ++row)
+	{
+		for (int col = sector.firstColumn; col < sector.firstColumn + sector.nrOfColumns; ++col)
+		{
+			const int nodeId{ row * m_NrOfColumns + col };
+			const int localIdx{ GetLocalIndex(sector, nodeId) };
+			if (m_LocalNextNodes[localIdx] != invalid_node_id)
+				field.directions[localIdx] = (pGraph->GetNodePos(m_LocalNextNodes[localIdx]) - pGraph->GetNodePos(nodeId)).GetNormalized();
+		}
+	}
+}
+
+void SectorFlowField::ClearLocalSearch()
+{
+	const size_t nrOfCells{ static_cast<size_t>(m_SectorSize) * m_SectorSize };
+	m_LocalCosts.assign(nrOfCells, UNREACHABLE_COST);
+	m_LocalNextNodes.assign(nrOfCells, invalid_node_id);
+	m_LocalOrigins.assign(nrOfCells, invalid_node_id);
+}
+
+// Seeds the local search with the goal and with the cells that lead out of the sector,
+// each crossing costs the cost of its window's portal plus the cost of stepping over the border
+void SectorFlowField::SeedSectorFromPortals(int sectorId)
+{
+	ClearLocalSearch();
+
+	const Sector& sector{ m_Sectors[sectorId] };
+	if (GetSectorId(m_GoalNodeId) == sectorId)
+		m_LocalCosts[GetLocalIndex(sector, m_GoalNodeId)] = 0.f;
+
+	for (int windowIdx : sector.exitWindows)
+	{
+		const Window& window{ m_Windows[windowIdx] };
+		const float portalCost{ m_PortalCosts[window.toPortalIdx] };
+		if (portalCost == UNREACHABLE_COST)
+			continue;
+
+		for (const Crossing& crossing : window.crossings)
+		{
+			const int localIdx{ GetLocalIndex(sector, crossing.fromNodeId) };
+			const float cost{ portalCost + crossing.cost };
+			if (cost < m_LocalCosts[localIdx])
+			{
+				m_LocalCosts[localIdx] = cost;
+				m_LocalNextNodes[localIdx] = crossing.toNodeId;
+				m_LocalOrigins[localIdx] = windowIdx;
+			}
+		}
+	}
+}
+
+// Seeds the local search with the goal and with the cells that lead into one of the first built fields,
+// each crossing costs the cost of the cell on the other side plus the cost of stepping over the border
+void SectorFlowField::SeedSectorFromFields(int sectorId, int nrOfBuiltFields)
+{
+	ClearLocalSearch();
+
+	const Sector& sector{ m_Sectors[sectorId] };
+	if (GetSectorId(m_GoalNodeId) == sectorId)
+		m_LocalCosts[GetLocalIndex(sector, m_GoalNodeId)] = 0.f;
+
+	for (int windowIdx : sector.exitWindows)
+	{
+		const Window& window{ m_Windows[windowIdx] };
+		const int toFieldId{ m_SectorFieldIds[window.toSectorId] };
+		if (toFieldId == invalid_node_id || toFieldId >= nrOfBuiltFields)
+			continue;
+
+		const Sector& toSector{ m_Sectors[window.toSectorId] };
+		const SectorField& toField{ m_SectorFields[toFieldId] };
+		for (const Crossing& crossing : window.crossings)
+		{
+			const float toCost{ toField.costs[GetLocalIndex(toSector, crossing.toNodeId)] };
+			if (toCost == UNREACHABLE_COST)
+				continue;
+
+			const int localIdx{ GetLocalIndex(sector, crossing.fromNodeId) };
+			const float cost{ toCost + crossing.cost };
+			if (cost < m_LocalCosts[localIdx])
+			{
+				m_LocalCosts[localIdx] = cost;
+				m_LocalNextNodes[localIdx] = crossing.toNodeId;
+				m_LocalOrigins[localIdx] = windowIdx;
+			}
+		}
+	}
+}
+
+// Dijkstra over the incoming connections, restricted to the cells of the sector and starting from the seeded cells
+void SectorFlowField::PropagateInSector(const GridGraph* pGraph, int sectorId)
+{
+	const DenseGrid& grid{ pGraph->GetDenseGrid() };
+	const Sector& sector{ m_Sectors[sectorId] };
+
+	m_OpenList.clear();
+	for (int localIdx = 0; localIdx < static_cast<int>(m_LocalCosts.size()); ++localIdx)
+	{
+		if (m_LocalCosts[localIdx] != UNREACHABLE_COST)
+			m_OpenList.push_back({ m_LocalCosts[localIdx], localIdx });
+	}
+	std::make_heap(m_OpenList.begin(), m_OpenList.end(), std::greater<std::pair<float, int>>{});
+
+	while (!m_OpenList.empty())
+	{
+		std::pop_heap(m_OpenList.begin(), m_OpenList.end(), std::greater<std::pair<float, int>>{});
+		const auto [cost, localIdx] = m_OpenList.back();
+		m_OpenList.pop_back();
+
+		if (cost != m_LocalCosts[localIdx])
+			continue;
+
+		const int col{ sector.firstColumn + localIdx % m_SectorSize };
+		const int row{ sector.firstRow + localIdx / m_SectorSize };
+		const int nodeId{ row * m_NrOfColumns + col };
+
+		for (int direction = 0; direction < NR_OF_DIRECTIONS; ++direction)
+		{
+			const int neighborCol{ col + DenseGrid::DIRECTION_OFFSETS[direction][0] };
+			const int neighborRow{ row + DenseGrid::DIRECTION_OFFSETS[direction][1] };
+			if (neighborCol < sector.firstColumn || neighborCol >= sector.firstColumn + sector.nrOfColumns
+				|| neighborRow < sector.firstRow || neighborRow >= sector.firstRow + sector.nrOfRows)
+				continue;
+
+			const int neighborId{ neighborRow * m_NrOfColumns + neighborCol };
+			const int oppositeDirection{ DenseGrid::OPPOSITE_DIRECTIONS[direction] };
+			if (!grid.HasConnection(neighborId, oppositeDirection))
+				continue;
+
+			const int neighborLocalIdx{ GetLocalIndex(sector, neighborId) };
+			const float newCost{ cost + grid.GetConnectionCost(neighborId, oppositeDirection) };
+			if (newCost < m_LocalCosts[neighborLocalIdx])
+			{
+				m_LocalCosts[neighborLocalIdx] = newCost;
+				m_LocalNextNodes[neighborLocalIdx] = nodeId;
+				m_LocalOrigins[neighborLocalIdx] = m_LocalOrigins[localIdx];
+				m_OpenList.push_back({ newCost, neighborLocalIdx });
+				std::push_heap(m_OpenList.begin(), m_OpenList.end(), std::greater<std::pair<float, int>>{});
+			}
+		}
+	}
+}
+
+int SectorFlowField::GetLocalIndex(const Sector& sector, int nodeId) const
+{
+	return (nodeId / m_NrOfColumns - sector.firstRow) * m_SectorSize + nodeId % m_NrOfColumns - sector.firstColumn;
+}
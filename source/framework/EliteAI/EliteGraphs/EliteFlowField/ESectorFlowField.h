@@ -0,0 +1,139 @@
+//*=================================================*/
+// ESectorFlowField.h: hierarchical flow field that splits a GridGraph into sectors connected by portals,
+// and only builds local flow fields for the sectors agents actually cross
+//*=================================================*/
+
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cfloat>
+#include "../EliteGraph/EGraphEnums.h"
+#include "../EliteGridGraph/EDenseGrid.h"
+
+namespace Elite
+{
+	class GridGraph;
+
+	class SectorFlowField final
+	{
+	public:
+		SectorFlowField() = default;
+		~SectorFlowField() = default;
+
+		// Value stored for cells that can't reach the goal or that are outside of the route
+		static constexpr float UNREACHABLE_COST{ FLT_MAX };
+
+		// Splits the grid into sectors and builds the portal graph between their borders.
+		// Has to be called again when the connections of the graph change.
+		void Build(const GridGraph* pGraph, int sectorSize);
+
+		// Searches the portal graph from the goal and builds the local flow fields of the sectors on the routes from the start nodes
+		void Calculate(const GridGraph* pGraph, int goalNodeId, const std::vector<int>& startNodeIds);
+
+		// Direction to move in from the node, a zero vector for the goal, for unreachable nodes and for nodes outside of the route
+		Vector2 GetDirection(int nodeId) const;
+		float GetCost(int nodeId) const;
+		bool IsSectorActive(int sectorId) const { return m_SectorFieldIds[sectorId] != invalid_node_id; }
+
+		int GetSectorId(int nodeId) const;
+		int GetSectorSize() const { return m_SectorSize; }
+		int GetNrOfSectors() const { return static_cast<int>(m_Sectors.size()); }
+		int GetNrOfActiveSectors() const { return static_cast<int>(m_ActiveSectorIds.size()); }
+		int GetNrOfPortals() const { return static_cast<int>(m_Portals.size()); }
+		int GetGoalNodeId() const { return m_GoalNodeId; }
+
+	private:
+		static constexpr int NR_OF_DIRECTIONS{ DenseGrid::NR_OF_DIRECTIONS };
+
+		struct PortalConnection
+		{
+			int portalIdx;
+			float cost;
+		};
+
+		// A cell on a sector border, with the connections from the other portals that lead into it
+		struct Portal
+		{
+			int nodeId;
+			int sectorId;
+			std::vector<PortalConnection> incomingConnections;
+		};
+
+		struct Crossing
+		{
+			int fromNodeId;
+			int toNodeId;
+			float cost;
+		};
+
+		// Run of connected cells along a border, leading from one sector into the next. The middle crossing is used as portal.
+		struct Window
+		{
+			int toSectorId;
+			int toPortalIdx;
+			std::vector<Crossing> crossings;
+		};
+
+		struct Sector
+		{
+			int firstColumn;
+			int firstRow;
+			int nrOfColumns;
+			int nrOfRows;
+			std::vector<int> portals;
+			std::vector<int> exitWindows;
+		};
+
+		// Local flow field of an active sector, indexed by the cell in the sector
+		struct SectorField
+		{
+			std::vector<float> costs;
+			std::vector<Vector2> directions;
+		};
+
+		int m_NrOfColumns{ 0 };
+		int m_NrOfRows{ 0 };
+		int m_SectorSize{ 0 };
+		int m_NrOfSectorColumns{ 0 };
+		int m_GoalNodeId{ invalid_node_id };
+
+		std::vector<Sector> m_Sectors{};
+		std::vector<Portal> m_Portals{};
+		std::vector<Window> m_Windows{};
+		std::unordered_map<int, int> m_PortalIds{};
+
+		// Abstract search results: cost from each portal to the goal and the next portal on the way there
+		std::vector<float> m_PortalCosts{};
+		std::vector<int> m_NextPortals{};
+
+		// Only the active sectors own a field, the fields are reused between calculations
+		std::vector<int> m_SectorFieldIds{};
+		std::vector<int> m_ActiveSectorIds{};
+		std::vector<SectorField> m_SectorFields{};
+
+		// Scratch buffers for the searches inside a sector
+		std::vector<float> m_LocalCosts{};
+		std::vector<int> m_LocalNextNodes{};
+		std::vector<int> m_LocalOrigins{};
+		std::vector<std::pair<float, int>> m_OpenList{};
+		std::vector<int> m_StartNodeIds{};
+		std::vector<float> m_SectorOrderKeys{};
+		std::vector<bool> m_IsPortalOnRoute{};
+
+		void AddWindows(const GridGraph* pGraph, int sectorId, int otherSectorId, bool isVertical);
+		void AddWindow(int fromSectorId, int toSectorId, std::vector<Crossing>& crossings);
+		int GetOrAddPortal(int nodeId);
+
+		void SearchPortals(const GridGraph* pGraph);
+		void ActivateRoutes(const GridGraph* pGraph, const std::vector<int>& startNodeIds);
+		void ActivateSector(int sectorId);
+		void BuildSectorFields(const GridGraph* pGraph);
+		void BuildSectorField(const GridGraph* pGraph, int sectorId, int nrOfBuiltFields);
+
+		void ClearLocalSearch();
+		void SeedSectorFromPortals(int sectorId);
+		void SeedSectorFromFields(int sectorId, int nrOfBuiltFields);
+		void PropagateInSector(const GridGraph* pGraph, int sectorId);
+		int GetLocalIndex(const Sector& sector, int nodeId) const;
+	};
+}
@@ -2,6 +2,10 @@
 #include "EGraph.h"
 #include "EGraphNode.h"
 #include "EGraphConnection.h"
+#include "EGraphCSR.h"
+#include "EGraphSpatialIndex.h"
+
+#include <functional>
 
 
 using namespace Elite;
@@ -45,17 +49,15 @@ Graph::Graph(const Graph& other)
 			m_pNodes.push_back(CloneNode(*n));
 		}
 	}
-	for (auto& cList : other.m_pConnections)
+	m_pConnections.resize(other.m_pConnections.size());
+	m_pIncomingConnections.resize(other.m_pConnections.size());
+	for (size_t nodeId = 0; nodeId < other.m_pConnections.size(); ++nodeId)
 	{
-
-		vector<GraphConnection*> newList;
-		for (auto& c : cList)
-			newList.push_back(new GraphConnection(*c));
-		m_pConnections.push_back(newList);
-
+		m_pConnections[nodeId].reserve(other.m_pConnections[nodeId].size());
+		for (auto& c : other.m_pConnections[nodeId])
+			LinkConnection(m_Arena.Create<GraphConnection>(*c));
 	}
-	UpdateNextNodeIndex();
-	UpdateActiveNodes();
+	RebuildNodeLists();
 }
 
 
@@ -68,18 +70,14 @@ Graph::~Graph()
 
 int Graph::AddNode(GraphNode* pNode)
 {
-	pNode->SetId(m_nextNodeId);
-	if (m_pNodes.size() < (size_t)m_nextNodeId + 1)
-	{
-		m_pNodes.resize(m_nextNodeId + 1);
-		m_pConnections.resize(m_nextNodeId + 1);
-	}
+	pNode->SetId(TakeNextNodeId());
 	m_pNodes[pNode->GetId()] = pNode;
+	AddActiveNode(pNode);
+	if (m_pSpatialIndex != nullptr)
+		m_pSpatialIndex->AddNode(pNode->GetId(), pNode->GetPosition());
 
 	++m_amountNodes;
-
-	UpdateNextNodeIndex();
-	UpdateActiveNodes();
+	++m_Revision;
 
 	return pNode->GetId();
 }
@@ -87,23 +85,39 @@ int Graph::AddNode(GraphNode* pNode)
 
 void Graph::Clear()
 {
+	// What lives in the arena only needs its destructor, the arena memory goes back in one go
 	for (auto& n : m_pNodes)
 	{
-		SAFE_DELETE(n);
+		if (m_Arena.Owns(n))
+			n->~GraphNode();
+		else
+			SAFE_DELETE(n);
 	}
 
 	for (auto& connections : m_pConnections)
 	{
 		for (auto& connection : connections)
 		{
-			SAFE_DELETE(connection);
+			if (m_Arena.Owns(connection))
+				connection->~GraphConnection();
+			else
+				SAFE_DELETE(connection);
 		}
 
 		connections.clear();
 	}
 	m_pConnections.clear();
+	m_pIncomingConnections.clear();
 	m_pNodes.clear();
+	m_pActiveNodes.clear();
+	m_FreeNodeIds.clear();
+	m_ActiveNodeIndices.clear();
+	m_pSpatialIndex.reset();
+	m_Arena.Release();
 	m_nextNodeId = 0;
+	m_amountNodes = 0;
+	m_amountConnections = 0;
+	++m_Revision;
 }
 
 
@@ -128,55 +142,22 @@ void Graph::RemoveNode(int index)
 	if (!IsNodeValid(index))
 		return;
 
+	RemoveConnectionsWithNode(index);
+
 	GraphNode* node = m_pNodes[index];
+	if (m_pSpatialIndex != nullptr)
+		m_pSpatialIndex->RemoveNode(index, node->GetPosition());
+	RemoveActiveNode(index);
 	node->SetId(invalid_node_id);
-	SAFE_DELETE(node);
+	DeleteNode(node);
 	m_pNodes[index] = nullptr;
 
-	--m_amountNodes;
-
-	bool hadConnections{ false };
-
-	//if the graph is not directed remove all connections leading to this pNode and then
-	//clear the connections leading from the pNode
-	if (!m_isDirectional)
-	{
-		//visit each neighbour and erase any connections leading to this pNode
-		for (auto currentConnection = m_pConnections[index].begin();
-			currentConnection != m_pConnections[index].end();
-			++currentConnection)
-		{
-			for (auto currentEdgeOnToNode = m_pConnections[(*currentConnection)->GetToNodeId()].begin();
-				currentEdgeOnToNode != m_pConnections[(*currentConnection)->GetToNodeId()].end();
-				++currentEdgeOnToNode)
-			{
-				if ((*currentEdgeOnToNode)->GetToNodeId() == index)
-				{
-					hadConnections = true;
-
-					auto conPtr = *currentEdgeOnToNode;
-					currentEdgeOnToNode = m_pConnections[(*currentConnection)->GetToNodeId()].erase(currentEdgeOnToNode);
-					--m_amountConnections;
-					SAFE_DELETE(conPtr);
-
-					break;
-				}
-			}
-		}
-	}
-
-
-	//finally, clear this pNode's connections
-	for (auto& connection : m_pConnections[index])
-	{
-		--m_amountConnections;
-		hadConnections = true;
-		SAFE_DELETE(connection);
-	}
-	m_pConnections[index].clear();
-
+	m_FreeNodeIds.push_back(index);
+	push_heap(m_FreeNodeIds.begin(), m_FreeNodeIds.end(), greater<int>{});
 	UpdateNextNodeIndex();
-	UpdateActiveNodes();
+
+	--m_amountNodes;
+	++m_Revision;
 }
 
 int Graph::GetNodeIdAtPosition(const Vector2& pos, float errorMargin) const
@@ -190,33 +171,26 @@ int Graph::GetNodeIdAtPosition(const Vector2& pos, float errorMargin) const
 
 GraphNode* Graph::GetNodeAtPosition(const Vector2& position, float errorMargin) const
 {
-	const float nodeRadiusSq = DEFAULT_NODE_RADIUS * DEFAULT_NODE_RADIUS * errorMargin * errorMargin;
-	auto foundIt = find_if(m_pActiveNodes.begin(), m_pActiveNodes.end(),
-		[position, nodeRadiusSq, this](GraphNode* pNode)
+	const float nodeRadius = DEFAULT_NODE_RADIUS * errorMargin;
+	GraphNode* pClosestNode = nullptr;
+	float closestDistSq = nodeRadius * nodeRadius;
+
+	GetSpatialIndex().VisitNodes(position, nodeRadius, [&](int nodeId)
 		{
-			return pNode->GetId() != invalid_node_id && (pNode->GetPosition() - position).MagnitudeSquared() < nodeRadiusSq;
+			const float distSq = (m_pNodes[nodeId]->GetPosition() - position).MagnitudeSquared();
+			if (distSq < closestDistSq)
+			{
+				pClosestNode = m_pNodes[nodeId];
+				closestDistSq = distSq;
+			}
 		});
 
-	if (foundIt != m_pActiveNodes.end())
-		return (*foundIt);
-	else
-		return nullptr;
+	return pClosestNode;
 }
 
 void Graph::AddNodeAtIndex(GraphNode* pNode, int index)
 {
-	pNode->SetId(m_nextNodeId);
-	if (m_pNodes.size() < (size_t)m_nextNodeId + 1)
-	{
-		m_pNodes.resize(m_nextNodeId + 1);
-		m_pConnections.resize(m_nextNodeId + 1);
-	}
-	m_pNodes[pNode->GetId()] = pNode;
-
-	++m_amountNodes;
-
-	UpdateNextNodeIndex();
-	UpdateActiveNodes();
+	AddNode(pNode);
 }
 
 
@@ -225,6 +199,48 @@ const vector<GraphNode*>& Graph::GetAllNodes() const
 	return m_pActiveNodes;
 }
 
+void Graph::SetNodePosition(int nodeId, const Vector2& position)
+{
+	assert(IsNodeValid(nodeId) && "<Graph::SetNodePosition>: invalid node index");
+
+	// The connections from and to the node are bucketed on its position as well
+	vector<GraphConnection*> pConnections{ m_pConnections[nodeId] };
+	if (m_isDirectional)
+	{
+		for (GraphConnection* pConnection : m_pIncomingConnections[nodeId])
+		{
+			if (pConnection->GetFromNodeId() != nodeId)
+				pConnections.push_back(pConnection);
+		}
+	}
+	else
+	{
+		for (GraphConnection* pConnection : m_pConnections[nodeId])
+		{
+			GraphConnection* pOpposite = pConnection->GetToNodeId() != nodeId ? GetConnection(pConnection->GetToNodeId(), nodeId) : nullptr;
+			if (pOpposite != nullptr)
+				pConnections.push_back(pOpposite);
+		}
+	}
+
+	if (m_pSpatialIndex != nullptr)
+	{
+		m_pSpatialIndex->RemoveNode(nodeId, m_pNodes[nodeId]->GetPosition());
+		for (GraphConnection* pConnection : pConnections)
+			RemoveFromSpatialIndex(pConnection);
+	}
+
+	m_pNodes[nodeId]->SetPosition(position);
+	++m_Revision;
+
+	if (m_pSpatialIndex != nullptr)
+	{
+		m_pSpatialIndex->AddNode(nodeId, position);
+		for (GraphConnection* pConnection : pConnections)
+			AddToSpatialIndex(pConnection);
+	}
+}
+
 //== CONNECTIONS ==
 
 
@@ -232,23 +248,27 @@ void Graph::AddConnection(GraphConnection* pConnection)
 {
 	assert(IsNodeValid(pConnection->GetFromNodeId()) && IsNodeValid(pConnection->GetToNodeId()) && "<Graph::AddConnection>: invalid node index");
 
-	m_pConnections[pConnection->GetFromNodeId()].push_back(pConnection);
+	LinkConnection(pConnection);
 	++m_amountConnections;
+	++m_Revision;
+	OnConnectionAdded(pConnection->GetFromNodeId(), pConnection->GetToNodeId(), pConnection->GetCost());
 
 	if (!m_isDirectional)
 	{
-		GraphConnection* oppositeConn = new GraphConnection();
-		oppositeConn->SetColor(pConnection->GetColor());
-		oppositeConn->SetCost(pConnection->GetCost());
-		oppositeConn->SetFromNodeId(pConnection->GetToNodeId());
-		oppositeConn->SetToNodeId(pConnection->GetFromNodeId());
+		GraphConnection* oppositeConn = m_Arena.Create<GraphConnection>(pConnection->GetToNodeId(), pConnection->GetFromNodeId(), pConnection->GetCost(), pConnection->GetColor());
 
-		m_pConnections[pConnection->GetToNodeId()].push_back(oppositeConn);
+		LinkConnection(oppositeConn);
 		++m_amountConnections;
+		OnConnectionAdded(oppositeConn->GetFromNodeId(), oppositeConn->GetToNodeId(), oppositeConn->GetCost());
 	}
 
 }
 
+void Graph::AddConnection(int fromNodeId, int toNodeId, float cost)
+{
+	AddConnection(m_Arena.Create<GraphConnection>(fromNodeId, toNodeId, cost));
+}
+
 
 GraphConnection* Graph::GetConnection(int from, int to) const
 {
@@ -270,39 +290,25 @@ void Graph::RemoveConnection(int from, int to)
 {
 	assert(IsNodeValid(from) && IsNodeValid(to));
 
-	auto conFromTo = GetConnection(from, to);
-	auto conToFrom = GetConnection(to, from);
-
+	// In a directional graph the opposite connection stays in the graph
 	if (!m_isDirectional)
 	{
-		for (auto curEdge = m_pConnections[to].begin();
-			curEdge != m_pConnections[to].end();
-			++curEdge)
+		if (GraphConnection* pConToFrom = UnlinkConnection(to, from))
 		{
-			if ((*curEdge)->GetToNodeId() == from)
-			{
-				curEdge = m_pConnections[to].erase(curEdge);
-				--m_amountConnections;
-				break;
-			}
+			--m_amountConnections;
+			OnConnectionRemoved(to, from);
+			DeleteConnection(pConToFrom);
 		}
 	}
 
-	for (auto curEdge = m_pConnections[from].begin();
-		curEdge != m_pConnections[from].end();
-		++curEdge)
+	if (GraphConnection* pConFromTo = UnlinkConnection(from, to))
 	{
-		if ((*curEdge)->GetToNodeId() == to)
-		{
-			curEdge = m_pConnections[from].erase(curEdge);
-			--m_amountConnections;
-			break;
-		}
+		--m_amountConnections;
+		OnConnectionRemoved(from, to);
+		DeleteConnection(pConFromTo);
 	}
 
-	SAFE_DELETE(conFromTo);
-	SAFE_DELETE(conToFrom);
-
+	++m_Revision;
 	OnGraphModified(false, true);
 
 }
@@ -315,22 +321,9 @@ void Graph::RemoveConnection(GraphConnection* pConnection)
 
 void Elite::Graph::RemoveAllConnectionsWithNode(int nodeId)
 {
-	for (auto c : m_pConnections[nodeId])
-		delete c;
-	m_pConnections[nodeId].clear();
-
-	// remove and delete connections from other nodes to this pNode
-	auto isConnectionToThisNode = [nodeId](GraphConnection* pCon) { return pCon->GetToNodeId() == nodeId; };
-	for (auto& c : m_pConnections)
-	{
-		std::vector<GraphConnection*>::iterator foundIt{};
-		while ((foundIt = std::find_if(c.begin(), c.end(), isConnectionToThisNode)) != c.end())
-		{
-			delete* foundIt;
-			c.erase(foundIt);
-		}
-	}
+	RemoveConnectionsWithNode(nodeId);
 
+	++m_Revision;
 	OnGraphModified(false, true);
 }
 
@@ -341,32 +334,44 @@ const vector<GraphConnection*>& Graph::GetConnectionsFromNode(int nodeId) const
 	return m_pConnections[nodeId];
 }
 
-GraphConnection* Graph::GetConnectionAtPosition(Vector2& position, float maxDist) const
+GraphConnection* Graph::GetConnectionAtPosition(const Vector2& position, float maxDist) const
 {
 	GraphConnection* result = nullptr;
 	float maxDistSq = maxDist * maxDist;
 
-	for (auto connectionList : m_pConnections)
-	{
-		for (auto connection : connectionList)
+	GetSpatialIndex().VisitConnections(position, maxDist, [&](GraphConnection* connection)
 		{
-			auto segmentStart = GetNode(connection->GetToNodeId())->GetPosition();
-			auto segmentEnd = GetNode(connection->GetFromNodeId())->GetPosition();
+			auto segmentStart = m_pNodes[connection->GetToNodeId()]->GetPosition();
+			auto segmentEnd = m_pNodes[connection->GetFromNodeId()]->GetPosition();
 
 			auto projectedPoint = ProjectOnLineSegment(segmentStart, segmentEnd, position);
 			float currentDistSq = DistanceSquared(projectedPoint, position);
-			if (currentDistSq < maxDist * maxDist)
+			if (currentDistSq < maxDistSq)
 			{
 				result = connection;
 				maxDistSq = currentDistSq;
 			}
-		}
-	}
+		});
 
 	return result;
 }
 
 
+void Graph::SetConnectionCost(int fromNodeId, int toNodeId, float cost)
+{
+	GraphConnection* pConnection = GetConnection(fromNodeId, toNodeId);
+	assert(pConnection != nullptr && "<Graph::SetConnectionCost>: connection doesn't exist");
+
+	SetConnectionCost(pConnection, cost);
+	++m_Revision;
+}
+
+void Graph::SetConnectionCost(GraphConnection* pConnection, float cost)
+{
+	pConnection->SetCost(cost);
+	OnConnectionCostChanged(pConnection->GetFromNodeId(), pConnection->GetToNodeId(), cost);
+}
+
 void Graph::SetConnectionCostsToDistances()
 {
 	for (auto& connections : m_pConnections)
@@ -375,35 +380,272 @@ void Graph::SetConnectionCostsToDistances()
 		{
 			Vector2 fromPos = GetNode(connection->GetFromNodeId())->GetPosition();
 			Vector2 toPos = GetNode(connection->GetToNodeId())->GetPosition();
-			connection->SetCost(abs(Distance(fromPos, toPos)));
+			SetConnectionCost(connection, abs(Distance(fromPos, toPos)));
 		}
 	}
+	++m_Revision;
 }
 
-void Graph::UpdateNextNodeIndex()
+void Graph::DeleteNode(GraphNode* pNode)
 {
-	int idx = 0;
-	while (true)
+	if (pNode == nullptr)
+		return;
+
+	if (!m_Arena.Owns(pNode))
+		delete pNode;
+	else if (m_pNodeFactory == nullptr)
+		m_Arena.Destroy(pNode);
+	else
+		m_pNodeFactory->DestroyNode(pNode, m_Arena);
+}
+
+void Graph::DeleteConnection(GraphConnection* pConnection)
+{
+	if (pConnection == nullptr)
+		return;
+
+	if (m_Arena.Owns(pConnection))
+		m_Arena.Destroy(pConnection);
+	else
+		delete pConnection;
+}
+
+shared_ptr<const GraphCSR> Graph::BuildCSR() const
+{
+	lock_guard<mutex> lock{ m_CSRMutex };
+	if (m_pCSR != nullptr && m_pCSR->revision == m_Revision)
+		return m_pCSR;
+
+	auto pCSR = make_shared<GraphCSR>();
+	pCSR->revision = m_Revision;
+	pCSR->nrOfNodes = GetNodeCapacity();
+	pCSR->connectionOffsets.reserve(pCSR->nrOfNodes + 1);
+	pCSR->toNodeIds.reserve(max(m_amountConnections, 0));
+	pCSR->costs.reserve(max(m_amountConnections, 0));
+
+	for (int nodeId = 0; nodeId < pCSR->nrOfNodes; ++nodeId)
 	{
-		if (!IsNodeValid(idx))
+		pCSR->connectionOffsets.push_back(static_cast<int>(pCSR->toNodeIds.size()));
+		if (!IsNodeValid(nodeId))
+			continue;
+
+		for (const GraphConnection* pConnection : m_pConnections[nodeId])
 		{
-			m_nextNodeId = idx;
-			return;
+			pCSR->toNodeIds.push_back(pConnection->GetToNodeId());
+			pCSR->costs.push_back(pConnection->GetCost());
 		}
-		++idx;
 	}
+	pCSR->connectionOffsets.push_back(static_cast<int>(pCSR->toNodeIds.size()));
+
+	m_pCSR = pCSR;
+	return m_pCSR;
 }
 
-void Graph::UpdateActiveNodes()
+// Puts the connection in the lists of its nodes, the caller counts it
+void Graph::LinkConnection(GraphConnection* pConnection)
 {
-	m_pActiveNodes.clear();
-	for (auto& n : m_pNodes)
+	m_pConnections[pConnection->GetFromNodeId()].push_back(pConnection);
+	if (m_isDirectional)
+		m_pIncomingConnections[pConnection->GetToNodeId()].push_back(pConnection);
+	AddToSpatialIndex(pConnection);
+}
+
+// Takes the connection out of the lists of its nodes without deleting it, nullptr if there is none.
+// Only the lists of the two nodes are searched, so it costs their degree.
+GraphConnection* Graph::UnlinkConnection(int fromNodeId, int toNodeId)
+{
+	auto& connections = m_pConnections[fromNodeId];
+	auto foundIt = find_if(connections.begin(), connections.end(), [toNodeId](GraphConnection* pCon) { return pCon->GetToNodeId() == toNodeId; });
+	if (foundIt == connections.end())
+		return nullptr;
+
+	GraphConnection* pConnection{ *foundIt };
+	connections.erase(foundIt);
+	RemoveFromSpatialIndex(pConnection);
+
+	if (m_isDirectional)
+	{
+		// The order of the incoming connections doesn't matter, so the last one fills the gap
+		auto& incomingConnections = m_pIncomingConnections[toNodeId];
+		*find(incomingConnections.begin(), incomingConnections.end(), pConnection) = incomingConnections.back();
+		incomingConnections.pop_back();
+	}
+	return pConnection;
+}
+
+// Removes and deletes every connection from and to the node, visiting only its own neighbours
+void Graph::RemoveConnectionsWithNode(int nodeId)
+{
+	// Connections to this node: in a directional graph they are in the incoming list,
+	// otherwise they are the opposites of the connections from it
+	if (m_isDirectional)
+	{
+		for (GraphConnection* pConnection : m_pIncomingConnections[nodeId])
+		{
+			auto& connections = m_pConnections[pConnection->GetFromNodeId()];
+			connections.erase(find(connections.begin(), connections.end(), pConnection));
+			RemoveFromSpatialIndex(pConnection);
+			--m_amountConnections;
+			OnConnectionRemoved(pConnection->GetFromNodeId(), nodeId);
+			DeleteConnection(pConnection);
+		}
+		m_pIncomingConnections[nodeId].clear();
+	}
+	else
+	{
+		for (GraphConnection* pConnection : m_pConnections[nodeId])
+		{
+			// A connection to itself is its own opposite, it goes with the connections from this node
+			if (pConnection->GetToNodeId() == nodeId)
+				continue;
+
+			if (GraphConnection* pOpposite = UnlinkConnection(pConnection->GetToNodeId(), nodeId))
+			{
+				--m_amountConnections;
+				OnConnectionRemoved(pOpposite->GetFromNodeId(), nodeId);
+				DeleteConnection(pOpposite);
+			}
+		}
+	}
+
+	// Connections from this node
+	for (GraphConnection* pConnection : m_pConnections[nodeId])
+	{
+		if (m_isDirectional)
+		{
+			auto& incomingConnections = m_pIncomingConnections[pConnection->GetToNodeId()];
+			*find(incomingConnections.begin(), incomingConnections.end(), pConnection) = incomingConnections.back();
+			incomingConnections.pop_back();
+		}
+		RemoveFromSpatialIndex(pConnection);
+		--m_amountConnections;
+		OnConnectionRemoved(nodeId, pConnection->GetToNodeId());
+		DeleteConnection(pConnection);
+	}
+	m_pConnections[nodeId].clear();
+}
+
+// The cells are about as big as the average connection, so a connection is in a few cells.
+// Without connections they hold about one node each, if the nodes are spread evenly.
+// The connections made after the index was built can be far longer or shorter than its cells, e.g. when the graph
+// started out empty, so it is built again once their average is off by more than a factor two.
+const GraphSpatialIndex& Graph::GetSpatialIndex() const
+{
+	lock_guard<mutex> lock{ m_SpatialIndexMutex };
+	if (m_pSpatialIndex != nullptr)
+	{
+		const float averageLength{ m_pSpatialIndex->GetAverageConnectionLength() };
+		const float indexCellSize{ m_pSpatialIndex->GetCellSize() };
+		const bool areCellsTooSmall{ averageLength > 2.f * indexCellSize };
+		const bool areCellsTooBig{ averageLength > 0.f && averageLength < 0.5f * indexCellSize && indexCellSize > DEFAULT_NODE_RADIUS };
+		if (!areCellsTooSmall && !areCellsTooBig)
+			return *m_pSpatialIndex;
+	}
+
+	float cellSize{ 0.f };
+	if (m_amountConnections > 0)
+	{
+		float totalLength{ 0.f };
+		for (const auto& connections : m_pConnections)
+		{
+			for (const GraphConnection* pConnection : connections)
+				totalLength += Distance(m_pNodes[pConnection->GetFromNodeId()]->GetPosition(), m_pNodes[pConnection->GetToNodeId()]->GetPosition());
+		}
+		cellSize = totalLength / m_amountConnections;
+	}
+	else if (m_pActiveNodes.size() > 1)
 	{
-		if (n != nullptr)
+		Vector2 minPosition{ m_pActiveNodes[0]->GetPosition() };
+		Vector2 maxPosition{ minPosition };
+		for (const GraphNode* pNode : m_pActiveNodes)
 		{
-			m_pActiveNodes.push_back(n);
+			minPosition = Vector2{ min(minPosition.x, pNode->GetPosition().x), min(minPosition.y, pNode->GetPosition().y) };
+			maxPosition = Vector2{ max(maxPosition.x, pNode->GetPosition().x), max(maxPosition.y, pNode->GetPosition().y) };
 		}
+		cellSize = max(maxPosition.x - minPosition.x, maxPosition.y - minPosition.y) / sqrtf(static_cast<float>(m_pActiveNodes.size()));
+	}
+
+	m_pSpatialIndex = make_unique<GraphSpatialIndex>(max(cellSize, DEFAULT_NODE_RADIUS));
+	for (const GraphNode* pNode : m_pActiveNodes)
+		m_pSpatialIndex->AddNode(pNode->GetId(), pNode->GetPosition());
+	for (const auto& connections : m_pConnections)
+	{
+		for (GraphConnection* pConnection : connections)
+			m_pSpatialIndex->AddConnection(pConnection, m_pNodes[pConnection->GetFromNodeId()]->GetPosition(), m_pNodes[pConnection->GetToNodeId()]->GetPosition());
+	}
+	return *m_pSpatialIndex;
+}
+
+void Graph::AddToSpatialIndex(GraphConnection* pConnection)
+{
+	if (m_pSpatialIndex != nullptr)
+		m_pSpatialIndex->AddConnection(pConnection, m_pNodes[pConnection->GetFromNodeId()]->GetPosition(), m_pNodes[pConnection->GetToNodeId()]->GetPosition());
+}
+
+void Graph::RemoveFromSpatialIndex(GraphConnection* pConnection)
+{
+	if (m_pSpatialIndex != nullptr)
+		m_pSpatialIndex->RemoveConnection(pConnection, m_pNodes[pConnection->GetFromNodeId()]->GetPosition(), m_pNodes[pConnection->GetToNodeId()]->GetPosition());
+}
+
+// Hands out the id m_nextNodeId pointed to and makes room for it. A new id grows the arrays by one,
+// which the vectors do in amortized constant time.
+int Graph::TakeNextNodeId()
+{
+	const int nodeId{ m_nextNodeId };
+	if (!m_FreeNodeIds.empty())
+	{
+		pop_heap(m_FreeNodeIds.begin(), m_FreeNodeIds.end(), greater<int>{});
+		m_FreeNodeIds.pop_back();
+	}
+	else
+	{
+		m_pNodes.push_back(nullptr);
+		m_pConnections.emplace_back();
+		m_pIncomingConnections.emplace_back();
+		m_ActiveNodeIndices.push_back(-1);
+	}
+
+	UpdateNextNodeIndex();
+	return nodeId;
+}
+
+void Graph::UpdateNextNodeIndex()
+{
+	m_nextNodeId = m_FreeNodeIds.empty() ? GetNodeCapacity() : m_FreeNodeIds.front();
+}
+
+void Graph::AddActiveNode(GraphNode* pNode)
+{
+	m_ActiveNodeIndices[pNode->GetId()] = static_cast<int>(m_pActiveNodes.size());
+	m_pActiveNodes.push_back(pNode);
+}
+
+// Moves the last active node into the gap, so the order of GetAllNodes changes on a removal
+void Graph::RemoveActiveNode(int nodeId)
+{
+	const int activeIdx{ m_ActiveNodeIndices[nodeId] };
+	GraphNode* pLastNode{ m_pActiveNodes.back() };
+	m_pActiveNodes[activeIdx] = pLastNode;
+	m_ActiveNodeIndices[pLastNode->GetId()] = activeIdx;
+	m_pActiveNodes.pop_back();
+	m_ActiveNodeIndices[nodeId] = -1;
+}
+
+void Graph::RebuildNodeLists()
+{
+	m_pActiveNodes.clear();
+	m_FreeNodeIds.clear();
+	m_ActiveNodeIndices.assign(m_pNodes.size(), -1);
+	for (int nodeId = 0; nodeId < GetNodeCapacity(); ++nodeId)
+	{
+		if (m_pNodes[nodeId] != nullptr)
+			AddActiveNode(m_pNodes[nodeId]);
+		else
+			m_FreeNodeIds.push_back(nodeId);
 	}
+	// Ascending ids already form a min-heap
+	UpdateNextNodeIndex();
 }
 
 shared_ptr<Graph> Graph::Clone() const
@@ -3,14 +3,19 @@
 //*=================================================*/
 
 #pragma once
+#include <memory>
+#include <mutex>
 #include "../EliteGraphUtilities/EGraphVisuals.h"
 #include "EGraphNode.h"
 #include "EGraphEnums.h"
+#include "EGraphArena.h"
 #include "../EliteGraphNodeFactory/EGraphNodeFactory.h"
 
 namespace Elite
 {
 	class GraphConnection;
+	class GraphSpatialIndex;
+	struct GraphCSR;
 
 	class Graph
 	{
@@ -22,9 +27,13 @@ namespace Elite
 		//Graph properties
 		bool IsDirectional() const { return m_isDirectional; }
 		int GetNextNodeId() const { return m_nextNodeId; }
+		int GetNodeCapacity() const { return static_cast<int>(m_pNodes.size()); } // Every node id is below it, for arrays indexed by node id
 		void Clear();
 		int GetAmountOfConnections() { return m_amountConnections; }
 		int GetAmountOfNodes() const { return m_amountNodes; }
+		// Goes up on every change to the nodes, the connections or their costs made through the graph,
+		// so data derived from the graph can tell it is outdated. Setting the cost on a connection directly doesn't count.
+		unsigned int GetRevision() const { return m_Revision; }
 
 		std::shared_ptr<Graph> Clone() const;
 
@@ -34,21 +43,34 @@ namespace Elite
 		int AddNode(GraphNode* pNode);
 		void RemoveNode(int nodeId);
 		const std::vector<GraphNode*>& GetAllNodes() const;
+		// Use it instead of GraphNode::SetPosition, the position lookups don't see a node that was moved directly
+		void SetNodePosition(int nodeId, const Vector2& position);
 
 		//Connections
+		// Takes ownership of the connection
 		void AddConnection(GraphConnection* pConnection);
+		// Creates the connection in the arena of the graph
+		void AddConnection(int fromNodeId, int toNodeId, float cost = 1.f);
 		GraphConnection* GetConnection(int fromNodeId, int toNodeId) const;
+		// Connections can't change their own cost, derived graphs keep a copy of the costs
+		void SetConnectionCost(int fromNodeId, int toNodeId, float cost);
 		void RemoveConnection(int fromNodeId, int toNodeId);
 		void RemoveConnection(GraphConnection* pConnection);
 		void RemoveAllConnectionsWithNode(int nodeId);
 
 		const std::vector<GraphConnection*>& GetConnectionsFromNode(int nodeId) const;
 		const std::vector<GraphConnection*>& GetConnectionsFromNode(GraphNode* pNode) const { return GetConnectionsFromNode(pNode->GetId()); }
-		GraphConnection* GetConnectionAtPosition(Vector2& position, float maxDist = 1.0f) const;
+		GraphConnection* GetConnectionAtPosition(const Vector2& position, float maxDist = 1.0f) const;
 
 		void SetConnectionCostsToDistances();
 
+		// Packed copy of the connections, only rebuilt when the graph changed since the last call. A snapshot never changes,
+		// so searches can keep using theirs while the graph is edited. It can be called from several threads at once.
+		std::shared_ptr<const GraphCSR> BuildCSR() const;
+
 		//Query nodes and connections
+		// The position lookups return the closest match. They use a spatial index that is built on the first lookup
+		// and kept up to date by every change after it.
 		int GetNodeIdAtPosition(const Vector2& position, float errorMargin) const;
 		GraphNode* GetNodeAtPosition(const Vector2& position, float errorMargin) const;
 		bool ConnectionExists(int fromNodeId, int toNodeId) const { return GetConnection(fromNodeId, toNodeId) != nullptr; }
@@ -60,24 +82,52 @@ namespace Elite
 
 	protected:
 		virtual void OnGraphModified(bool nrOfNodesChanged, bool nrOfConnectionsChanged) {}
+		virtual void OnConnectionAdded(int fromNodeId, int toNodeId, float cost) {}
+		virtual void OnConnectionCostChanged(int fromNodeId, int toNodeId, float cost) {}
+		virtual void OnConnectionRemoved(int fromNodeId, int toNodeId) {}
+		void SetConnectionCost(GraphConnection* pConnection, float cost);
 		void AddNodeAtIndex(GraphNode* pNode, int index);
 
 		bool m_isDirectional;
 		int m_nextNodeId{ 0 };
+		unsigned int m_Revision{ 0 };
 		std::vector<GraphNode*> m_pNodes;
 		std::vector<std::vector<GraphConnection*>>m_pConnections;
+		// Per node id, the connections leading to it. Only kept for directional graphs, in the others every
+		// connection to a node has its opposite among the connections from it.
+		std::vector<std::vector<GraphConnection*>> m_pIncomingConnections;
 		std::vector<GraphNode*> m_pActiveNodes;
+		std::vector<int> m_FreeNodeIds; // Ids of removed nodes, a min-heap so the lowest one is reused first
+		std::vector<int> m_ActiveNodeIndices; // Per node id, where the node is in m_pActiveNodes
 
 		std::shared_ptr<GraphNodeFactory> m_pNodeFactory;
+		// Memory of the nodes and connections the graph creates itself, the ones it was given are deleted one by one
+		GraphArena m_Arena;
 
-		GraphNode* CreateNode(const Vector2& pos) { return m_pNodeFactory == nullptr ? new GraphNode(pos) : m_pNodeFactory->CreateNode(pos); }
-		GraphNode* CloneNode(const GraphNode& other) { return m_pNodeFactory == nullptr ? new GraphNode(other) : m_pNodeFactory->CloneNode(other); }
+		GraphNode* CreateNode(const Vector2& pos) { return m_pNodeFactory == nullptr ? m_Arena.Create<GraphNode>(pos) : m_pNodeFactory->CreateNode(pos, m_Arena); }
+		GraphNode* CloneNode(const GraphNode& other) { return m_pNodeFactory == nullptr ? m_Arena.Create<GraphNode>(other) : m_pNodeFactory->CloneNode(other, m_Arena); }
+		void DeleteNode(GraphNode* pNode);
+		void DeleteConnection(GraphConnection* pConnection);
 	private:
 		int m_amountNodes{ 0 };
 		int m_amountConnections{ 0 };
 
+		mutable std::shared_ptr<const GraphCSR> m_pCSR{};
+		mutable std::mutex m_CSRMutex{};
+		mutable std::unique_ptr<GraphSpatialIndex> m_pSpatialIndex{};
+		mutable std::mutex m_SpatialIndexMutex{};
+
+		void LinkConnection(GraphConnection* pConnection);
+		GraphConnection* UnlinkConnection(int fromNodeId, int toNodeId);
+		void RemoveConnectionsWithNode(int nodeId);
+		const GraphSpatialIndex& GetSpatialIndex() const;
+		void AddToSpatialIndex(GraphConnection* pConnection);
+		void RemoveFromSpatialIndex(GraphConnection* pConnection);
+		int TakeNextNodeId();
 		void UpdateNextNodeIndex();
-		void UpdateActiveNodes();
+		void AddActiveNode(GraphNode* pNode);
+		void RemoveActiveNode(int nodeId);
+		void RebuildNodeLists();
 	};
 
 
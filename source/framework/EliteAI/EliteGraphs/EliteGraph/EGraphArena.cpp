@@ -0,0 +1,78 @@
+#include "stdafx.h"
+#include "EGraphArena.h"
+
+#include <functional>
+
+using namespace Elite;
+
+bool GraphArena::Owns(const void* pObject) const
+{
+	const std::byte* pAddress{ static_cast<const std::byte*>(pObject) };
+	auto chunkIt = std::upper_bound(m_Chunks.begin(), m_Chunks.end(), pAddress,
+		[](const std::byte* pAddress, const Chunk& chunk) { return std::less<const std::byte*>{}(pAddress, chunk.pMemory.get()); });
+	if (chunkIt == m_Chunks.begin())
+		return false;
+
+	--chunkIt;
+	return std::less<const std::byte*>{}(pAddress, chunkIt->pMemory.get() + chunkIt->size);
+}
+
+void GraphArena::Release()
+{
+	m_Chunks.clear();
+	m_FreeLists.clear();
+	m_pNextSlot = nullptr;
+	m_pChunkEnd = nullptr;
+	m_NextChunkSize = FIRST_CHUNK_SIZE;
+}
+
+void* GraphArena::Allocate(size_t size)
+{
+	const size_t slotSize{ GetSlotSize(size) };
+	for (FreeList& freeList : m_FreeLists)
+	{
+		if (freeList.slotSize == slotSize && freeList.pFirstSlot != nullptr)
+		{
+			void* pSlot{ freeList.pFirstSlot };
+			freeList.pFirstSlot = *static_cast<void**>(pSlot);
+			return pSlot;
+		}
+	}
+
+	if (static_cast<size_t>(m_pChunkEnd - m_pNextSlot) < slotSize)
+		AddChunk(slotSize);
+
+	void* pSlot{ m_pNextSlot };
+	m_pNextSlot += slotSize;
+	return pSlot;
+}
+
+void GraphArena::Deallocate(void* pSlot, size_t size)
+{
+	const size_t slotSize{ GetSlotSize(size) };
+	auto freeListIt = std::find_if(m_FreeLists.begin(), m_FreeLists.end(), [slotSize](const FreeList& freeList) { return freeList.slotSize == slotSize; });
+	if (freeListIt == m_FreeLists.end())
+	{
+		m_FreeLists.push_back({ slotSize, nullptr });
+		freeListIt = m_FreeLists.end() - 1;
+	}
+
+	*static_cast<void**>(pSlot) = freeListIt->pFirstSlot;
+	freeListIt->pFirstSlot = pSlot;
+}
+
+// The chunks double in size up to a maximum, so big graphs end up in a few chunks and Owns stays cheap.
+// What is left of the previous chunk isn't used anymore.
+void GraphArena::AddChunk(size_t minSize)
+{
+	const size_t chunkSize{ max(m_NextChunkSize, minSize) };
+	m_NextChunkSize = min(chunkSize * 2, MAX_CHUNK_SIZE);
+
+	Chunk chunk{ std::unique_ptr<std::byte[]>(new std::byte[chunkSize]), chunkSize };
+	m_pNextSlot = chunk.pMemory.get();
+	m_pChunkEnd = m_pNextSlot + chunkSize;
+
+	auto insertIt = std::upper_bound(m_Chunks.begin(), m_Chunks.end(), m_pNextSlot,
+		[](const std::byte* pAddress, const Chunk& chunk) { return std::less<const std::byte*>{}(pAddress, chunk.pMemory.get()); });
+	m_Chunks.insert(insertIt, std::move(chunk));
+}
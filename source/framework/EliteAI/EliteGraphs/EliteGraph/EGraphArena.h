@@ -0,0 +1,79 @@
+//*=================================================*/
+// EGraphArena.h: Slab allocator for the nodes and connections of a graph
+//*=================================================*/
+
+#pragma once
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cstddef>
+
+namespace Elite
+{
+	// Hands out the memory for the nodes and connections of one graph from a few big chunks instead of a heap block each.
+	// Destroyed objects go on a free list per size for the next ones, and Release gives every chunk back at once,
+	// so tearing down a graph doesn't free its objects one by one. Objects that were made with new can be told apart with Owns.
+	class GraphArena final
+	{
+	public:
+		GraphArena() = default;
+		~GraphArena() = default;
+
+		template<typename T, typename... Args>
+		T* Create(Args&&... args);
+		// T has to be the type the object was created as
+		template<typename T>
+		void Destroy(T* pObject);
+
+		bool Owns(const void* pObject) const;
+		// Gives back all memory at once, the objects in it have to be destroyed first or have a destructor that does nothing
+		void Release();
+
+	private:
+		static constexpr size_t SLOT_ALIGNMENT{ alignof(void*) };
+		static constexpr size_t FIRST_CHUNK_SIZE{ 16 * 1024 };
+		static constexpr size_t MAX_CHUNK_SIZE{ 4 * 1024 * 1024 };
+
+		struct Chunk
+		{
+			std::unique_ptr<std::byte[]> pMemory;
+			size_t size;
+		};
+
+		// Destroyed slots of one size, every free slot holds the pointer to the next one
+		struct FreeList
+		{
+			size_t slotSize;
+			void* pFirstSlot;
+		};
+
+		std::vector<Chunk> m_Chunks{}; // Sorted on address, for Owns
+		std::vector<FreeList> m_FreeLists{};
+		std::byte* m_pNextSlot{ nullptr };
+		std::byte* m_pChunkEnd{ nullptr };
+		size_t m_NextChunkSize{ FIRST_CHUNK_SIZE };
+
+		void* Allocate(size_t size);
+		void Deallocate(void* pSlot, size_t size);
+		void AddChunk(size_t minSize);
+		static size_t GetSlotSize(size_t size) { return (max(size, sizeof(void*)) + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT; }
+
+		GraphArena(const GraphArena&) = delete;
+		GraphArena& operator=(const GraphArena&) = delete;
+	};
+
+	template<typename T, typename... Args>
+	inline T* GraphArena::Create(Args&&... args)
+	{
+		static_assert(alignof(T) <= SLOT_ALIGNMENT, "<GraphArena::Create>: type needs a bigger alignment than the arena gives");
+		return new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+	}
+
+	template<typename T>
+	inline void GraphArena::Destroy(T* pObject)
+	{
+		pObject->~T();
+		Deallocate(pObject, sizeof(T));
+	}
+}
@@ -0,0 +1,33 @@
+//*=================================================*/
+// EGraphCSR.h: Read-only copy of the connections of a graph, for searches
+//*=================================================*/
+
+#pragma once
+#include <vector>
+
+namespace Elite
+{
+	// Connections in compressed sparse row layout: those of node n are [connectionOffsets[n], connectionOffsets[n + 1])
+	// in toNodeIds and costs. Searches read it instead of the GraphConnection objects, so their inner loop only walks
+	// packed arrays. Removed nodes have no connections.
+	struct GraphCSR
+	{
+		unsigned int revision{ 0 }; // Revision of the graph it was built from
+		int nrOfNodes{ 0 }; // Node capacity of the graph, every node id is below it
+		std::vector<int> connectionOffsets{};
+		std::vector<int> toNodeIds{};
+		std::vector<float> costs{};
+
+		int GetFirstConnection(int nodeId) const { return connectionOffsets[nodeId]; }
+		int GetEndConnection(int nodeId) const { return connectionOffsets[nodeId + 1]; }
+		bool HasConnections(int nodeId) const { return connectionOffsets[nodeId + 1] > connectionOffsets[nodeId]; }
+
+		// Calls function(toNodeId, cost) for every connection from the node
+		template<typename Function>
+		void ForEachConnection(int nodeId, Function function) const
+		{
+			for (int connectionIdx = GetFirstConnection(nodeId); connectionIdx < GetEndConnection(nodeId); ++connectionIdx)
+				function(toNodeIds[connectionIdx], costs[connectionIdx]);
+		}
+	};
+}
@@ -21,7 +21,6 @@ namespace Elite
 		void SetToNodeId(int id) { m_ToId = id; }
 
 		float GetCost() const { return m_Cost; }
-		void SetCost(float newCost) { m_Cost = newCost; }
 
 		const Color& GetColor() const { return m_Color; }
 		void SetColor(const Color& color) { m_Color = color; }
@@ -37,6 +36,9 @@ namespace Elite
 		int m_ToId;
 		float m_Cost;
 
+		// Graph::SetConnectionCost keeps the data the graph derives from the costs up to date
+		friend class Graph;
+		void SetCost(float newCost) { m_Cost = newCost; }
 	};
 }
 
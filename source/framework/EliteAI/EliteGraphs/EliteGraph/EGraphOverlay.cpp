@@ -0,0 +1,44 @@
+#include "stdafx.h"
+#include "EGraphOverlay.h"
+
+using namespace Elite;
+
+GraphOverlay::GraphOverlay(const Graph* pBaseGraph)
+	: m_pBaseGraph{ pBaseGraph }
+	, m_pBaseCSR{ pBaseGraph->BuildCSR() }
+{
+}
+
+int GraphOverlay::AddNode(GraphNode* pNode)
+{
+	pNode->SetId(GetNodeCapacity());
+	m_pNodes.emplace_back(pNode);
+	return pNode->GetId();
+}
+
+void GraphOverlay::AddConnection(int fromNodeId, int toNodeId, float cost)
+{
+	assert(GetNode(fromNodeId) != nullptr && GetNode(toNodeId) != nullptr && "<GraphOverlay::AddConnection>: invalid node index");
+
+	m_Connections.push_back({ fromNodeId, toNodeId, cost });
+	if (!IsDirectional())
+		m_Connections.push_back({ toNodeId, fromNodeId, cost });
+}
+
+GraphNode* GraphOverlay::GetNode(int nodeId) const
+{
+	if (!IsOverlayNode(nodeId))
+		return m_pBaseGraph->GetNode(nodeId);
+
+	const size_t overlayIdx{ static_cast<size_t>(nodeId - m_pBaseCSR->nrOfNodes) };
+	return overlayIdx < m_pNodes.size() ? m_pNodes[overlayIdx].get() : nullptr;
+}
+
+Vector2 GraphOverlay::GetNodePos(int nodeId) const
+{
+	if (!IsOverlayNode(nodeId))
+		return m_pBaseGraph->GetNodePos(nodeId);
+
+	const GraphNode* pNode{ GetNode(nodeId) };
+	return pNode == nullptr ? Vector2{ 0,0 } : pNode->GetPosition();
+}
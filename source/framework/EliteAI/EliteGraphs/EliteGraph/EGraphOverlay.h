@@ -0,0 +1,70 @@
+//*=================================================*/
+// EGraphOverlay.h: Extra nodes and connections on top of a graph, without copying it
+//*=================================================*/
+
+#pragma once
+#include <memory>
+#include <vector>
+#include "EGraph.h"
+#include "EGraphCSR.h"
+
+namespace Elite
+{
+	// Adds a few nodes and connections to a graph for one search, e.g. a start and goal position that aren't nodes of it.
+	// The graph itself is left alone: the overlay reads a CSR snapshot of its connections, so several overlays can search
+	// the same graph at once from different threads, as long as the graph isn't edited meanwhile.
+	// The nodes of the overlay get the ids from the node capacity of the graph upward.
+	class GraphOverlay final
+	{
+	public:
+		explicit GraphOverlay(const Graph* pBaseGraph);
+		~GraphOverlay() = default;
+
+		const Graph* GetBaseGraph() const { return m_pBaseGraph; }
+		const GraphCSR& GetBaseCSR() const { return *m_pBaseCSR; }
+		bool IsDirectional() const { return m_pBaseGraph->IsDirectional(); }
+		int GetNodeCapacity() const { return m_pBaseCSR->nrOfNodes + static_cast<int>(m_pNodes.size()); }
+		bool IsOverlayNode(int nodeId) const { return nodeId >= m_pBaseCSR->nrOfNodes; }
+
+		// Takes ownership of the node and returns its id
+		int AddNode(GraphNode* pNode);
+		// Either node can be one of the graph or one of the overlay. An undirected graph gets the opposite connection as well.
+		void AddConnection(int fromNodeId, int toNodeId, float cost = 1.f);
+
+		GraphNode* GetNode(int nodeId) const;
+		Vector2 GetNodePos(int nodeId) const;
+
+		// Calls function(toNodeId, cost) for the connections of the graph from the node, then for the ones the overlay added
+		template<typename Function>
+		void ForEachConnection(int nodeId, Function function) const;
+
+	private:
+		struct Connection
+		{
+			int fromNodeId;
+			int toNodeId;
+			float cost;
+		};
+
+		const Graph* m_pBaseGraph;
+		std::shared_ptr<const GraphCSR> m_pBaseCSR;
+		std::vector<std::unique_ptr<GraphNode>> m_pNodes{};
+		std::vector<Connection> m_Connections{}; // Only a handful per search, so they are simply all checked
+
+		GraphOverlay(const GraphOverlay&) = delete;
+		GraphOverlay& operator=(const GraphOverlay&) = delete;
+	};
+
+	template<typename Function>
+	inline void GraphOverlay::ForEachConnection(int nodeId, Function function) const
+	{
+		if (!IsOverlayNode(nodeId))
+			m_pBaseCSR->ForEachConnection(nodeId, function);
+
+		for (const Connection& connection : m_Connections)
+		{
+			if (connection.fromNodeId == nodeId)
+				function(connection.toNodeId, connection.cost);
+		}
+	}
+}
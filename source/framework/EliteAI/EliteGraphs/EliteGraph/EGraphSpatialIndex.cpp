@@ -0,0 +1,59 @@
+#include "stdafx.h"
+#include "EGraphSpatialIndex.h"
+
+using namespace Elite;
+
+namespace
+{
+	// Order doesn't matter within a cell, so the last item fills the gap
+	template<typename T>
+	void SwapRemove(std::vector<T>& items, const T& item)
+	{
+		auto foundIt = std::find(items.begin(), items.end(), item);
+		if (foundIt == items.end())
+			return;
+
+		*foundIt = items.back();
+		items.pop_back();
+	}
+}
+
+GraphSpatialIndex::GraphSpatialIndex(float cellSize)
+	: m_CellSize{ cellSize }
+{
+}
+
+void GraphSpatialIndex::AddNode(int nodeId, const Vector2& position)
+{
+	m_Cells[GetCellKey(GetCellCoordinate(position.x), GetCellCoordinate(position.y))].nodeIds.push_back(nodeId);
+}
+
+void GraphSpatialIndex::RemoveNode(int nodeId, const Vector2& position)
+{
+	auto cellIt = m_Cells.find(GetCellKey(GetCellCoordinate(position.x), GetCellCoordinate(position.y)));
+	if (cellIt != m_Cells.end())
+		SwapRemove(cellIt->second.nodeIds, nodeId);
+}
+
+void GraphSpatialIndex::AddConnection(GraphConnection* pConnection, const Vector2& fromPosition, const Vector2& toPosition)
+{
+	const Vector2 minPosition{ min(fromPosition.x, toPosition.x), min(fromPosition.y, toPosition.y) };
+	const Vector2 maxPosition{ max(fromPosition.x, toPosition.x), max(fromPosition.y, toPosition.y) };
+	ForEachCell(minPosition, maxPosition, [this, pConnection](long long key) { m_Cells[key].pConnections.push_back(pConnection); });
+	m_TotalConnectionLength += Distance(fromPosition, toPosition);
+	++m_NrOfConnections;
+}
+
+void GraphSpatialIndex::RemoveConnection(GraphConnection* pConnection, const Vector2& fromPosition, const Vector2& toPosition)
+{
+	const Vector2 minPosition{ min(fromPosition.x, toPosition.x), min(fromPosition.y, toPosition.y) };
+	const Vector2 maxPosition{ max(fromPosition.x, toPosition.x), max(fromPosition.y, toPosition.y) };
+	ForEachCell(minPosition, maxPosition, [this, pConnection](long long key)
+		{
+			auto cellIt = m_Cells.find(key);
+			if (cellIt != m_Cells.end())
+				SwapRemove(cellIt->second.pConnections, pConnection);
+		});
+	m_TotalConnectionLength -= Distance(fromPosition, toPosition);
+	--m_NrOfConnections;
+}
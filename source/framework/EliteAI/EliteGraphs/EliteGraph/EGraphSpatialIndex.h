@@ -0,0 +1,97 @@
+//*=================================================*/
+// EGraphSpatialIndex.h: Uniform grid over the nodes and connections of a graph, for picking
+//*=================================================*/
+
+#pragma once
+#include <vector>
+#include <unordered_map>
+
+namespace Elite
+{
+	class GraphConnection;
+
+	// Buckets node ids on the cell their position is in, and connections on every cell the bounding box
+	// of their segment touches, so a lookup around a position only looks at the items of a few cells.
+	// It doesn't know the graph: whoever adds an item has to remove it with the same positions.
+	class GraphSpatialIndex final
+	{
+	public:
+		explicit GraphSpatialIndex(float cellSize);
+		~GraphSpatialIndex() = default;
+
+		float GetCellSize() const { return m_CellSize; }
+		// Average length of the connections in the index, 0 without connections
+		float GetAverageConnectionLength() const { return m_NrOfConnections > 0 ? static_cast<float>(m_TotalConnectionLength / m_NrOfConnections) : 0.f; }
+
+		void AddNode(int nodeId, const Vector2& position);
+		void RemoveNode(int nodeId, const Vector2& position);
+		void AddConnection(GraphConnection* pConnection, const Vector2& fromPosition, const Vector2& toPosition);
+		void RemoveConnection(GraphConnection* pConnection, const Vector2& fromPosition, const Vector2& toPosition);
+
+		// Calls visitor(nodeId) or visitor(pConnection) for everything in the cells that overlap the square around the position.
+		// A connection can be visited more than once.
+		template<typename Visitor>
+		void VisitNodes(const Vector2& position, float radius, Visitor visitor) const;
+		template<typename Visitor>
+		void VisitConnections(const Vector2& position, float radius, Visitor visitor) const;
+
+	private:
+		struct Cell
+		{
+			std::vector<int> nodeIds;
+			std::vector<GraphConnection*> pConnections;
+		};
+
+		float m_CellSize;
+		std::unordered_map<long long, Cell> m_Cells{};
+		double m_TotalConnectionLength{ 0.0 };
+		int m_NrOfConnections{ 0 };
+
+		int GetCellCoordinate(float value) const { return static_cast<int>(floorf(value / m_CellSize)); }
+		static long long GetCellKey(int column, int row) { return (static_cast<long long>(column) << 32) | static_cast<unsigned int>(row); }
+		template<typename Function>
+		void ForEachCell(const Vector2& minPosition, const Vector2& maxPosition, Function function) const;
+	};
+
+	template<typename Function>
+	inline void GraphSpatialIndex::ForEachCell(const Vector2& minPosition, const Vector2& maxPosition, Function function) const
+	{
+		const int lastColumn{ GetCellCoordinate(maxPosition.x) };
+		const int lastRow{ GetCellCoordinate(maxPosition.y) };
+		for (int row = GetCellCoordinate(minPosition.y); row <= lastRow; ++row)
+		{
+			for (int column = GetCellCoordinate(minPosition.x); column <= lastColumn; ++column)
+				function(GetCellKey(column, row));
+		}
+	}
+
+	template<typename Visitor>
+	inline void GraphSpatialIndex::VisitNodes(const Vector2& position, float radius, Visitor visitor) const
+	{
+		const Vector2 extent{ radius, radius };
+		ForEachCell(position - extent, position + extent, [this, &visitor](long long key)
+			{
+				auto cellIt = m_Cells.find(key);
+				if (cellIt == m_Cells.end())
+					return;
+
+				for (int nodeId : cellIt->second.nodeIds)
+					visitor(nodeId);
+			});
+	}
+
+	template<typename Visitor>
+	inline void GraphSpatialIndex::VisitConnections(const Vector2& position, float radius, Visitor visitor) const
+	{
+		const Vector2 extent{ radius, radius };
+		ForEachCell(position - extent, position + extent, [this, &visitor](long long key)
+			{
+				auto cellIt = m_Cells.find(key);
+				if (cellIt == m_Cells.end())
+					return;
+
+				for (GraphConnection* pConnection : cellIt->second.pConnections)
+					visitor(pConnection);
+			});
+	}
+}
@@ -1,48 +1,309 @@
 #pragma once
 #include <algorithm>
+#include <cfloat>
+#include <concepts>
 #include "../EliteGraph/EGraph.h"
-#include "../EliteGraph/EGraphConnection.h"
+#include "../EliteGraph/EGraphCSR.h"
 #include "../EliteGraph/EGraphNode.h"
+#include "../EliteGraph/EGraphOverlay.h"
+#include "../EliteGridGraph/EGridGraph.h"
 #include "EHeuristic.h"
+#include "ELandmarkHeuristic.h"
+#include "ESearchContext.h"
 
 namespace Elite
 {
+	// Node positions through the virtual Graph::GetNodePos, works for every graph
+	class GraphNodePositions
+	{
+	public:
+		explicit GraphNodePositions(const Graph* pGraph) : m_pGraph(pGraph) {}
+		Vector2 GetPosition(int nodeId) const { return m_pGraph->GetNodePos(nodeId); }
+
+	private:
+		const Graph* m_pGraph;
+	};
+
+	// Computes the center of the cell from the node id, like GridGraph::GetNodePos
+	class GridNodePositions
+	{
+	public:
+		explicit GridNodePositions(const GridGraph* pGraph) : m_NrOfColumns(pGraph->GetColumns()), m_CellSize(pGraph->GetCellSize()) {}
+		Vector2 GetPosition(int nodeId) const { return { (nodeId % m_NrOfColumns + .5f) * m_CellSize, (nodeId / m_NrOfColumns + .5f) * m_CellSize }; }
+
+	private:
+		int m_NrOfColumns;
+		float m_CellSize;
+	};
 
+	// The heuristic is a function pointer or a function object from HeuristicPolicies, the node positions come from one of the
+	// classes above. AStar{ pGraph, HeuristicFunctions::Octile } picks the heuristic at runtime, while e.g.
+	// AStar<HeuristicPolicies::Octile, GridNodePositions>{ pGridGraph, {} } lets the compiler inline both calls in the search loop.
+	template<typename HeuristicPolicy = Heuristic, typename GraphPolicy = GraphNodePositions>
 	class AStar
 	{
 	public:
-		AStar(Graph* pGraph, Heuristic hFunction);
+		// Takes the highest of both heuristics when there are landmarks, they know about walls and terrain costs
+		template<typename GraphType> requires std::derived_from<GraphType, Graph>
+		AStar(GraphType* pGraph, HeuristicPolicy heuristic, const LandmarkHeuristic* pLandmarkHeuristic = nullptr);
+		// Searches the graph of the overlay together with the nodes and connections the overlay adds. There are no landmarks:
+		// they were measured without the connections of the overlay, which can make paths cheaper.
+		AStar(const GraphOverlay* pOverlay, HeuristicPolicy heuristic);
 
-		// stores the optimal connection to a node and its total costs related to the start and end node of the path
-		struct NodeRecord
-		{
-			GraphNode* pNode = nullptr;
-			GraphConnection* pConnection = nullptr;
-			float costSoFar = 0.f; // accumulated g-costs of all the connections leading up to this one
-			float estimatedTotalCost = 0.f; // f-cost (= costSoFar + h-cost)
+		// Searches with the context of the calling thread
+		std::vector<GraphNode*> FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode);
+		// Searches with the given context, its node records stay valid until it is used again
+		std::vector<GraphNode*> FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode, SearchContext& context);
 
-			bool operator==(const NodeRecord& other) const
-			{
-				return pNode == other.pNode
-					&& pConnection == other.pConnection
-					&& costSoFar == other.costSoFar
-					&& estimatedTotalCost == other.estimatedTotalCost;
-			};
+		// Searches from both ends at once and stops when no path through the open nodes can be cheaper than the cheapest
+		// one where both searches met. The path costs as much as the one of FindPath when the heuristic is consistent,
+		// i.e. never more than the cost of a connection plus the estimate from the node it leads to (Euclidean and Octile
+		// on grids, the landmarks). Only undirected graphs can be searched backward, directed ones and overlays fall back to FindPath.
+		std::vector<GraphNode*> FindPathBidirectional(GraphNode* pStartNode, GraphNode* pDestinationNode);
+		std::vector<GraphNode*> FindPathBidirectional(GraphNode* pStartNode, GraphNode* pDestinationNode, SearchContext& forwardContext, SearchContext& backwardContext);
 
-			bool operator<(const NodeRecord& other) const
-			{
-				return estimatedTotalCost < other.estimatedTotalCost;
-			};
+		// Nodes taken off the open heap by the last search
+		int GetNrOfExpandedNodes() const { return m_NrOfExpandedNodes; }
+
+	private:
+		// Start or goal node of a bidirectional search
+		struct SearchEnd
+		{
+			int nodeId;
+			Vector2 position;
 		};
 
-		std::vector<GraphNode*> FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode);
+		// Positions in a search over an overlay: its own nodes know theirs, the others come from the position policy
+		struct OverlayPositions
+		{
+			const GraphPolicy& positions;
+			const GraphOverlay& overlay;
+			Vector2 GetPosition(int nodeId) const { return overlay.IsOverlayNode(nodeId) ? overlay.GetNodePos(nodeId) : positions.GetPosition(nodeId); }
+		};
 
-	private:
-		float GetHeuristicCost(GraphNode* pStartNode, GraphNode* pEndNode) const;
+		// The search of FindPath over the connections of a CSR or an overlay, nodes gives the GraphNode of an id
+		template<typename ConnectionsType, typename PositionsType, typename NodesType>
+		std::vector<GraphNode*> SearchPath(const ConnectionsType& connections, int nodeCapacity, const PositionsType& positions, const NodesType& nodes, GraphNode* pStartNode, GraphNode* pGoalNode, SearchContext& context);
+		template<typename PositionsType>
+		float GetHeuristicCost(const PositionsType& positions, int nodeId, int goalNodeId, const Vector2& goalPos) const;
+		float GetPotential(int nodeId, const SearchEnd& target, const SearchEnd& source) const;
+		void ExpandCheapest(const GraphCSR& csr, SearchContext& context, const SearchContext& otherContext, const SearchEnd& target, const SearchEnd& source, float& bestCost, int& meetingNodeId);
 
-		Graph* m_pGraph;
-		Heuristic m_HeuristicFunction;
+		const Graph* m_pGraph;
+		HeuristicPolicy m_Heuristic;
+		GraphPolicy m_Positions;
+		const LandmarkHeuristic* m_pLandmarkHeuristic{ nullptr };
+		const GraphOverlay* m_pOverlay{ nullptr };
+		int m_NrOfExpandedNodes{ 0 };
 	};
 
-	
-}
\ No newline at end of file
+	template<typename HeuristicPolicy, typename GraphPolicy>
+	template<typename GraphType> requires std::derived_from<GraphType, Graph>
+	inline AStar<HeuristicPolicy, GraphPolicy>::AStar(GraphType* pGraph, HeuristicPolicy heuristic, const LandmarkHeuristic* pLandmarkHeuristic)
+		: m_pGraph(pGraph)
+		, m_Heuristic(heuristic)
+		, m_Positions(pGraph)
+		, m_pLandmarkHeuristic(pLandmarkHeuristic)
+	{
+	}
+
+	template<typename HeuristicPolicy, typename GraphPolicy>
+	inline AStar<HeuristicPolicy, GraphPolicy>::AStar(const GraphOverlay* pOverlay, HeuristicPolicy heuristic)
+		: m_pGraph(pOverlay->GetBaseGraph())
+		, m_Heuristic(heuristic)
+		, m_Positions(pOverlay->GetBaseGraph())
+		, m_pOverlay(pOverlay)
+	{
+	}
+
+	template<typename HeuristicPolicy, typename GraphPolicy>
+	inline std::vector<GraphNode*> AStar<HeuristicPolicy, GraphPolicy>::FindPath(GraphNode* pStartNode, GraphNode* pGoalNode)
+	{
+		return FindPath(pStartNode, pGoalNode, SearchContext::GetThreadContext());
+	}
+
+	template<typename HeuristicPolicy, typename GraphPolicy>
+	inline std::vector<GraphNode*> AStar<HeuristicPolicy, GraphPolicy>::FindPath(GraphNode* pStartNode, GraphNode* pGoalNode, SearchContext& context)
+	{
+		if (m_pOverlay != nullptr)
+			return SearchPath(*m_pOverlay, m_pOverlay->GetNodeCapacity(), OverlayPositions{ m_Positions, *m_pOverlay }, *m_pOverlay, pStartNode, pGoalNode, context);
+
+		const std::shared_ptr<const GraphCSR> pCSR{ m_pGraph->BuildCSR() };
+		return SearchPath(*pCSR, pCSR->nrOfNodes, m_Positions, *m_pGraph, pStartNode, pGoalNode, context);
+	}
+
+	template<typename HeuristicPolicy, typename GraphPolicy>
+	template<typename ConnectionsType, typename PositionsType, typename NodesType>
+	inline std::vector<GraphNode*> AStar<HeuristicPolicy, GraphPolicy>::SearchPath(const ConnectionsType& connections, int nodeCapacity, const PositionsType& positions, const NodesType& nodes, GraphNode* pStartNode, GraphNode* pGoalNode, SearchContext& context)
+	{
+		std::vector<GraphNode*> path{};
+		context.Reset(nodeCapacity);
+		m_NrOfExpandedNodes = 0;
+
+		// 1. Put the start node on the open heap to start the while loop
+		const int startNodeId{ pStartNode->GetId() };
+		const int goalNodeId{ pGoalNode->GetId() };
+		const Vector2 goalPos{ positions.GetPosition(goalNodeId) };
+		SearchContext::NodeRecord& startRecord{ context.Visit(startNodeId) };
+		startRecord.estimatedTotalCost = GetHeuristicCost(positions, startNodeId, goalNodeId, goalPos);
+		context.PushOrDecrease(startNodeId);
+
+		while (!context.IsHeapEmpty())
+		{
+			// A. Get the node with the lowest estimated total cost, it moves to the closed set
+			const int currentNodeId{ context.PopCheapest() };
+			const float currentCost{ context.GetRecord(currentNodeId).costSoFar };
+			++m_NrOfExpandedNodes;
+
+			// B. Check if that record refers to the end node
+			if (currentNodeId == goalNodeId)
+			{
+				// 3. Reconstruct path from last connection to start node with backtracking
+				for (int nodeId = goalNodeId; nodeId != startNodeId; nodeId = context.GetRecord(nodeId).parentNodeId)
+				{
+					path.push_back(nodes.GetNode(nodeId));
+				}
+				path.push_back(pStartNode);
+				std::reverse(path.begin(), path.end());
+				return path;
+			}
+
+			// C. For each connection from the current node
+			connections.ForEachConnection(currentNodeId, [&](int nextNodeId, float connectionCost)
+				{
+					const float newCost{ currentCost + connectionCost };
+
+					// D. A node that was already reached, open or closed, only gets a new record when the connection is cheaper.
+					// Closed nodes are reopened, so heuristics that aren't consistent still give the optimal path.
+					if (context.IsVisited(nextNodeId) && context.GetRecord(nextNodeId).costSoFar <= newCost)
+						return;
+
+					// E. Update the record and put it on the heap, or move it up when it already was on it
+					SearchContext::NodeRecord& nextRecord{ context.IsVisited(nextNodeId) ? context.GetRecord(nextNodeId) : context.Visit(nextNodeId) };
+					nextRecord.parentNodeId = currentNodeId;
+					nextRecord.costSoFar = newCost;
+					nextRecord.estimatedTotalCost = newCost + GetHeuristicCost(positions, nextNodeId, goalNodeId, goalPos);
+					context.PushOrDecrease(nextNodeId);
+				});
+		}
+
+		// If no path is found, return an empty path
+		return path;
+	}
+
+	template<typename HeuristicPolicy, typename GraphPolicy>
+	inline std::vector<GraphNode*> AStar<HeuristicPolicy, GraphPolicy>::FindPathBidirectional(GraphNode* pStartNode, GraphNode* pGoalNode)
+	{
+		return FindPathBidirectional(pStartNode, pGoalNode, SearchContext::GetThreadContext(), SearchContext::GetThreadBackwardContext());
+	}
+
+	// Bidirectional Dijkstra on the connection costs reduced by the average of the heuristic towards the goal and the one
+	// towards the start: cost(u, v) - p(u) + p(v), with p(v) = (h(v, goal) - h(v, start)) / 2 forward and -p(v) backward.
+	// Both searches see the same reduced costs, which lets them stop as soon as the cheapest open nodes of both sides
+	// together can't beat the cheapest path found so far.
+	template<typename HeuristicPolicy, typename GraphPolicy>
+	inline std::vector<GraphNode*> AStar<HeuristicPolicy, GraphPolicy>::FindPathBidirectional(GraphNode* pStartNode, GraphNode* pGoalNode, SearchContext& forwardContext, SearchContext& backwardContext)
+	{
+		if (m_pGraph->IsDirectional() || m_pOverlay != nullptr)
+			return FindPath(pStartNode, pGoalNode, forwardContext);
+
+		std::vector<GraphNode*> path{};
+		const std::shared_ptr<const GraphCSR> pCSR{ m_pGraph->BuildCSR() };
+		m_NrOfExpandedNodes = 0;
+
+		const SearchEnd start{ pStartNode->GetId(), m_Positions.GetPosition(pStartNode->GetId()) };
+		const SearchEnd goal{ pGoalNode->GetId(), m_Positions.GetPosition(pGoalNode->GetId()) };
+
+		forwardContext.Reset(pCSR->nrOfNodes);
+		forwardContext.Visit(start.nodeId).estimatedTotalCost = GetPotential(start.nodeId, goal, start);
+		forwardContext.PushOrDecrease(start.nodeId);
+		backwardContext.Reset(pCSR->nrOfNodes);
+		backwardContext.Visit(goal.nodeId).estimatedTotalCost = GetPotential(goal.nodeId, start, goal);
+		backwardContext.PushOrDecrease(goal.nodeId);
+
+		// Cheapest path found so far, through the node where both searches met
+		float bestCost{ start.nodeId == goal.nodeId ? 0.f : FLT_MAX };
+		int meetingNodeId{ start.nodeId == goal.nodeId ? start.nodeId : invalid_node_id };
+
+		while (!forwardContext.IsHeapEmpty() && !backwardContext.IsHeapEmpty())
+		{
+			// The potentials cancel out over a whole path, so every path that isn't found yet costs at least the sum of
+			// the keys of the cheapest open node on both sides
+			const float forwardKey{ forwardContext.GetRecord(forwardContext.GetCheapest()).estimatedTotalCost };
+			const float backwardKey{ backwardContext.GetRecord(backwardContext.GetCheapest()).estimatedTotalCost };
+			if (forwardKey + backwardKey >= bestCost)
+				break;
+
+			// Expand the side with the fewest open nodes
+			if (forwardContext.GetHeapSize() <= backwardContext.GetHeapSize())
+				ExpandCheapest(*pCSR, forwardContext, backwardContext, goal, start, bestCost, meetingNodeId);
+			else
+				ExpandCheapest(*pCSR, backwardContext, forwardContext, start, goal, bestCost, meetingNodeId);
+		}
+
+		if (meetingNodeId == invalid_node_id)
+			return path;
+
+		// Backtrack from the meeting node to the start node, and then follow the backward records to the goal node
+		for (int nodeId = meetingNodeId; nodeId != start.nodeId; nodeId = forwardContext.GetRecord(nodeId).parentNodeId)
+		{
+			path.push_back(m_pGraph->GetNode(nodeId));
+		}
+		path.push_back(pStartNode);
+		std::reverse(path.begin(), path.end());
+
+		for (int nodeId = meetingNodeId; nodeId != goal.nodeId; )
+		{
+			nodeId = backwardContext.GetRecord(nodeId).parentNodeId;
+			path.push_back(m_pGraph->GetNode(nodeId));
+		}
+		return path;
+	}
+
+	// One step of either half of the bidirectional search, towards the target and away from the source. The backward search
+	// follows the connections of the undirected graph the other way around, so its parents lead to the goal.
+	template<typename HeuristicPolicy, typename GraphPolicy>
+	inline void AStar<HeuristicPolicy, GraphPolicy>::ExpandCheapest(const GraphCSR& csr, SearchContext& context, const SearchContext& otherContext, const SearchEnd& target, const SearchEnd& source, float& bestCost, int& meetingNodeId)
+	{
+		const int currentNodeId{ context.PopCheapest() };
+		const float currentCost{ context.GetRecord(currentNodeId).costSoFar };
+		++m_NrOfExpandedNodes;
+
+		for (int connectionIdx = csr.GetFirstConnection(currentNodeId); connectionIdx < csr.GetEndConnection(currentNodeId); ++connectionIdx)
+		{
+			const int nextNodeId{ csr.toNodeIds[connectionIdx] };
+			const float newCost{ currentCost + csr.costs[connectionIdx] };
+
+			if (context.IsVisited(nextNodeId) && context.GetRecord(nextNodeId).costSoFar <= newCost)
+				continue;
+
+			SearchContext::NodeRecord& nextRecord{ context.IsVisited(nextNodeId) ? context.GetRecord(nextNodeId) : context.Visit(nextNodeId) };
+			nextRecord.parentNodeId = currentNodeId;
+			nextRecord.costSoFar = newCost;
+			nextRecord.estimatedTotalCost = newCost + GetPotential(nextNodeId, target, source);
+			context.PushOrDecrease(nextNodeId);
+
+			// Both searches reached this node, which gives a path from the start to the goal
+			if (otherContext.IsVisited(nextNodeId) && newCost + otherContext.GetRecord(nextNodeId).costSoFar < bestCost)
+			{
+				bestCost = newCost + otherContext.GetRecord(nextNodeId).costSoFar;
+				meetingNodeId = nextNodeId;
+			}
+		}
+	}
+
+	template<typename HeuristicPolicy, typename GraphPolicy>
+	inline float AStar<HeuristicPolicy, GraphPolicy>::GetPotential(int nodeId, const SearchEnd& target, const SearchEnd& source) const
+	{
+		return .5f * (GetHeuristicCost(m_Positions, nodeId, target.nodeId, target.position) - GetHeuristicCost(m_Positions, nodeId, source.nodeId, source.position));
+	}
+
+	template<typename HeuristicPolicy, typename GraphPolicy>
+	template<typename PositionsType>
+	inline float AStar<HeuristicPolicy, GraphPolicy>::GetHeuristicCost(const PositionsType& positions, int nodeId, int goalNodeId, const Vector2& goalPos) const
+	{
+		const Vector2 toDestination{ goalPos - positions.GetPosition(nodeId) };
+		const float cost{ m_Heuristic(abs(toDestination.x), abs(toDestination.y)) };
+		return m_pLandmarkHeuristic == nullptr ? cost : max(cost, m_pLandmarkHeuristic->GetCost(nodeId, goalNodeId));
+	}
+}
@@ -3,7 +3,8 @@
 
 #include "../EliteGraph/EGraph.h"
 #include "../EliteGraph/EGraphNode.h"
-#include "../EliteGraph/EGraphConnection.h"
+#include "../EliteGraph/EGraphCSR.h"
+#include "ESearchContext.h"
 
 using namespace Elite;
 
@@ -12,57 +13,150 @@ BFS::BFS(Graph* pGraph)
 {
 }
 
-//Breath First Search Algorithm searches for a path from the startNode to the destinationNode
 std::vector<GraphNode*> BFS::FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode)
 {
-    std::vector<GraphNode*> path{};
-
-    std::queue<GraphNode*>openList{};
-    std::map<GraphNode*, GraphNode*> closedList{};
-
-    openList.push(pStartNode);
-
-    while (!openList.empty())
-    {
-        GraphNode* currentNode = openList.front();
-        openList.pop();
-
-        if (currentNode == pDestinationNode)
-        {
-            break;
-        }
-
-        for (const GraphConnection* connection : m_pGraph->GetConnectionsFromNode(currentNode))
-        {
-            GraphNode* nextNode = m_pGraph->GetNode(connection->GetToNodeId());
-
-            if (!closedList.contains(nextNode))
-            {
-                openList.push(nextNode);
-                closedList[nextNode] = currentNode;
-            }
-        }
-    }
-
-    //check if the destination is reachable if not return empty path
-    if (!closedList.contains(pDestinationNode))
-    {
-        return path;
-    }
-
-    //backtracking to build the path
-
-    GraphNode* currentNode = pDestinationNode;
+	return FindPath(pStartNode, pDestinationNode, SearchContext::GetThreadContext());
+}
 
-    while (currentNode != pStartNode)
-    {
-        path.emplace_back(currentNode);
-        currentNode = closedList[currentNode];
-    }
+//Breath First Search Algorithm searches for a path from the startNode to the destinationNode
+std::vector<GraphNode*> BFS::FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode, SearchContext& context)
+{
+	std::vector<GraphNode*> path{};
+	const std::shared_ptr<const GraphCSR> pCSR{ m_pGraph->BuildCSR() };
+	const GraphCSR& csr{ *pCSR };
+
+	// The records of the context remember from which node every node was reached first
+	context.Reset(csr.nrOfNodes);
+	context.Visit(pStartNode->GetId());
+	context.PushBack(pStartNode->GetId());
+
+	const int destinationNodeId{ pDestinationNode->GetId() };
+	while (!context.IsQueueEmpty())
+	{
+		const int currentNodeId{ context.PopFront() };
+
+		if (currentNodeId == destinationNodeId)
+		{
+			break;
+		}
+
+		for (int connectionIdx = csr.GetFirstConnection(currentNodeId); connectionIdx < csr.GetEndConnection(currentNodeId); ++connectionIdx)
+		{
+			const int nextNodeId{ csr.toNodeIds[connectionIdx] };
+
+			if (!context.IsVisited(nextNodeId))
+			{
+				context.Visit(nextNodeId).parentNodeId = currentNodeId;
+				context.PushBack(nextNodeId);
+			}
+		}
+	}
+
+	//check if the destination is reachable if not return empty path
+	if (!context.IsVisited(destinationNodeId))
+	{
+		return path;
+	}
+
+	//backtracking to build the path
+	for (int nodeId = destinationNodeId; nodeId != pStartNode->GetId(); nodeId = context.GetRecord(nodeId).parentNodeId)
+	{
+		path.emplace_back(m_pGraph->GetNode(nodeId));
+	}
+
+	path.emplace_back(pStartNode);
+
+	std::reverse(path.begin(), path.end());
+
+	return path;
+}
 
-    path.emplace_back(pStartNode);
+std::vector<GraphNode*> BFS::FindPathBidirectional(GraphNode* pStartNode, GraphNode* pDestinationNode)
+{
+	return FindPathBidirectional(pStartNode, pDestinationNode, SearchContext::GetThreadContext(), SearchContext::GetThreadBackwardContext());
+}
 
-    std::reverse(path.begin(), path.end());
+// Both searches grow one layer at a time, the record costs hold the number of connections from their own end
+std::vector<GraphNode*> BFS::FindPathBidirectional(GraphNode* pStartNode, GraphNode* pDestinationNode, SearchContext& forwardContext, SearchContext& backwardContext)
+{
+	if (m_pGraph->IsDirectional())
+		return FindPath(pStartNode, pDestinationNode, forwardContext);
+
+	std::vector<GraphNode*> path{};
+	const std::shared_ptr<const GraphCSR> pCSR{ m_pGraph->BuildCSR() };
+	const int startNodeId{ pStartNode->GetId() };
+	const int destinationNodeId{ pDestinationNode->GetId() };
+
+	forwardContext.Reset(pCSR->nrOfNodes);
+	forwardContext.Visit(startNodeId);
+	forwardContext.PushBack(startNodeId);
+	backwardContext.Reset(pCSR->nrOfNodes);
+	backwardContext.Visit(destinationNodeId);
+	backwardContext.PushBack(destinationNodeId);
+
+	// Grow the smallest frontier, so a start in a dead end doesn't make the other side flood the map
+	int meetingNodeId{ startNodeId == destinationNodeId ? startNodeId : invalid_node_id };
+	while (meetingNodeId == invalid_node_id && !forwardContext.IsQueueEmpty() && !backwardContext.IsQueueEmpty())
+	{
+		if (forwardContext.GetQueueSize() <= backwardContext.GetQueueSize())
+			meetingNodeId = ExpandLayer(*pCSR, forwardContext, backwardContext);
+		else
+			meetingNodeId = ExpandLayer(*pCSR, backwardContext, forwardContext);
+	}
+
+	if (meetingNodeId == invalid_node_id)
+		return path;
+
+	//backtracking to build the path, from the meeting node to the start and then from the meeting node to the destination
+	for (int nodeId = meetingNodeId; nodeId != startNodeId; nodeId = forwardContext.GetRecord(nodeId).parentNodeId)
+	{
+		path.emplace_back(m_pGraph->GetNode(nodeId));
+	}
+	path.emplace_back(pStartNode);
+	std::reverse(path.begin(), path.end());
+
+	for (int nodeId = meetingNodeId; nodeId != destinationNodeId; )
+	{
+		nodeId = backwardContext.GetRecord(nodeId).parentNodeId;
+		path.emplace_back(m_pGraph->GetNode(nodeId));
+	}
+
+	return path;
+}
 
-    return path;
-}
\ No newline at end of file
+// Visits all neighbours of the nodes in the queue and returns the node where the shortest path through the other search
+// goes, or invalid_node_id. The whole layer is expanded, the first node that meets isn't always on the shortest path.
+int BFS::ExpandLayer(const GraphCSR& csr, SearchContext& context, const SearchContext& otherContext) const
+{
+	int meetingNodeId{ invalid_node_id };
+	float meetingLength{ 0.f };
+
+	for (size_t layerSize = context.GetQueueSize(); layerSize > 0; --layerSize)
+	{
+		const int currentNodeId{ context.PopFront() };
+		const float nextLength{ context.GetRecord(currentNodeId).costSoFar + 1.f };
+
+		for (int connectionIdx = csr.GetFirstConnection(currentNodeId); connectionIdx < csr.GetEndConnection(currentNodeId); ++connectionIdx)
+		{
+			const int nextNodeId{ csr.toNodeIds[connectionIdx] };
+			if (context.IsVisited(nextNodeId))
+				continue;
+
+			SearchContext::NodeRecord& nextRecord{ context.Visit(nextNodeId) };
+			nextRecord.parentNodeId = currentNodeId;
+			nextRecord.costSoFar = nextLength;
+			context.PushBack(nextNodeId);
+
+			if (otherContext.IsVisited(nextNodeId))
+			{
+				const float length{ nextLength + otherContext.GetRecord(nextNodeId).costSoFar };
+				if (meetingNodeId == invalid_node_id || length < meetingLength)
+				{
+					meetingNodeId = nextNodeId;
+					meetingLength = length;
+				}
+			}
+		}
+	}
+	return meetingNodeId;
+}
@@ -4,15 +4,28 @@ namespace Elite
 {
 	class Graph;
 	class GraphNode;
+	class SearchContext;
+	struct GraphCSR;
 
 	class BFS
 	{
 	public:
 		BFS(Graph* pGraph);
 
+		// Searches with the context of the calling thread
 		std::vector<GraphNode*> FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode);
+		// Searches with the given context, so repeated searches don't allocate anything but the path
+		std::vector<GraphNode*> FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode, SearchContext& context);
+
+		// Searches from both ends at once and stops where they meet, a path with as few connections as FindPath gives.
+		// Only undirected graphs can be searched backward, directed ones fall back to FindPath.
+		std::vector<GraphNode*> FindPathBidirectional(GraphNode* pStartNode, GraphNode* pDestinationNode);
+		std::vector<GraphNode*> FindPathBidirectional(GraphNode* pStartNode, GraphNode* pDestinationNode, SearchContext& forwardContext, SearchContext& backwardContext);
+
 	private:
 		Graph* m_pGraph;
+
+		int ExpandLayer(const GraphCSR& csr, SearchContext& context, const SearchContext& otherContext) const;
 	};
 
 }
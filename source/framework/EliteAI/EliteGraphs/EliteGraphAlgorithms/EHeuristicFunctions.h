@@ -43,4 +43,33 @@ namespace Elite
 			return max(x, y);
 		}
 	};
+
+	// The same functions as function objects, a search that takes one as template argument can inline the call
+	namespace HeuristicPolicies
+	{
+		struct Manhattan
+		{
+			float operator()(float x, float y) const { return HeuristicFunctions::Manhattan(x, y); }
+		};
+
+		struct Euclidean
+		{
+			float operator()(float x, float y) const { return HeuristicFunctions::Euclidean(x, y); }
+		};
+
+		struct SqEuclidean
+		{
+			float operator()(float x, float y) const { return HeuristicFunctions::SqEuclidean(x, y); }
+		};
+
+		struct Octile
+		{
+			float operator()(float x, float y) const { return HeuristicFunctions::Octile(x, y); }
+		};
+
+		struct Chebyshev
+		{
+			float operator()(float x, float y) const { return HeuristicFunctions::Chebyshev(x, y); }
+		};
+	}
 }
\ No newline at end of file
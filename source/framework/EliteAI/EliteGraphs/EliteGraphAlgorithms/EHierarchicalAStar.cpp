@@ -0,0 +1,466 @@
+#include "stdafx.h"
+#include "EHierarchicalAStar.h"
+
+#include "../EliteGridGraph/EGridGraph.h"
+
+using namespace Elite;
+
+namespace
+{
+	// Offsets (col, row) of the clusters that come after a cluster: the left or upper cluster of a border owns its crossings
+	constexpr int NEXT_CLUSTER_OFFSETS[][2]{ { 1, 0 }, { 0, 1 }, { 1, 1 }, { -1, 1 } };
+}
+
+HierarchicalAStar::HierarchicalAStar(const GridGraph* pGraph, int clusterSize)
+	: m_pGraph(pGraph)
+	, m_ClusterSize(max(clusterSize, 1))
+{
+}
+
+std::vector<GraphNode*> HierarchicalAStar::FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode)
+{
+	const std::vector<GraphNode*> abstractPath{ FindAbstractPath(pStartNode, pDestinationNode) };
+	if (abstractPath.size() < 2)
+		return abstractPath;
+
+	std::vector<GraphNode*> path{ pStartNode };
+	for (size_t idx = 1; idx < abstractPath.size(); ++idx)
+	{
+		const std::vector<GraphNode*> segment{ RefineSegment(abstractPath[idx - 1], abstractPath[idx]) };
+		if (segment.empty())
+			return {};
+
+		path.insert(path.end(), segment.begin() + 1, segment.end());
+	}
+	return path;
+}
+
+std::vector<GraphNode*> HierarchicalAStar::FindAbstractPath(GraphNode* pStartNode, GraphNode* pDestinationNode)
+{
+	std::vector<GraphNode*> path{};
+	UpdateClusters();
+
+	const int startNodeId{ pStartNode->GetId() };
+	const int goalNodeId{ pDestinationNode->GetId() };
+	const Cluster& startCluster{ m_Clusters[GetClusterId(startNodeId)] };
+	const int goalClusterId{ GetClusterId(goalNodeId) };
+	const Cluster& goalCluster{ m_Clusters[goalClusterId] };
+	m_NrOfExpandedNodes = 0;
+
+	// The start and goal node are only connected to the entrances of their own cluster, and only for this search
+	SearchCluster(startCluster, startNodeId, invalid_node_id, false, m_StartCosts);
+	SearchCluster(goalCluster, goalNodeId, invalid_node_id, true, m_GoalCosts);
+
+	SearchContext& context{ SearchContext::GetThreadContext() };
+	context.Reset(m_pGraph->GetNodeCapacity());
+	AddSuccessor(context, startNodeId, invalid_node_id, 0.f, goalNodeId);
+
+	while (!context.IsHeapEmpty())
+	{
+		const int nodeId{ context.PopCheapest() };
+		const float costSoFar{ context.GetRecord(nodeId).costSoFar };
+		++m_NrOfExpandedNodes;
+
+		if (nodeId == goalNodeId)
+		{
+			for (int pathNodeId = goalNodeId; pathNodeId != invalid_node_id; pathNodeId = context.GetRecord(pathNodeId).parentNodeId)
+			{
+				path.push_back(m_pGraph->GetNode(pathNodeId));
+			}
+			std::reverse(path.begin(), path.end());
+			return path;
+		}
+
+		const int clusterId{ GetClusterId(nodeId) };
+		const Cluster& cluster{ m_Clusters[clusterId] };
+		if (clusterId == goalClusterId)
+		{
+			const float costToGoal{ m_GoalCosts[GetLocalIndex(goalCluster, nodeId)] };
+			if (costToGoal != UNREACHABLE_COST)
+				AddSuccessor(context, goalNodeId, nodeId, costSoFar + costToGoal, goalNodeId);
+		}
+
+		if (nodeId == startNodeId)
+		{
+			for (const Entrance& entrance : startCluster.entrances)
+			{
+				const float cost{ m_StartCosts[GetLocalIndex(startCluster, entrance.nodeId)] };
+				if (cost != UNREACHABLE_COST && entrance.nodeId != startNodeId)
+					AddSuccessor(context, entrance.nodeId, nodeId, cost, goalNodeId);
+			}
+		}
+
+		const int entranceIdx{ m_EntranceIndices[nodeId] };
+		if (entranceIdx == invalid_node_id)
+			continue;
+
+		const int nrOfEntrances{ static_cast<int>(cluster.entrances.size()) };
+		for (int toEntranceIdx = 0; toEntranceIdx < nrOfEntrances; ++toEntranceIdx)
+		{
+			const float cost{ cluster.entranceCosts[entranceIdx * nrOfEntrances + toEntranceIdx] };
+			if (cost != UNREACHABLE_COST && toEntranceIdx != entranceIdx)
+				AddSuccessor(context, cluster.entrances[toEntranceIdx].nodeId, nodeId, costSoFar + cost, goalNodeId);
+		}
+		for (const Exit& exit : cluster.entrances[entranceIdx].exits)
+		{
+			AddSuccessor(context, exit.toNodeId, nodeId, costSoFar + exit.cost, goalNodeId);
+		}
+	}
+
+	// If no path is found, return an empty path
+	return path;
+}
+
+std::vector<GraphNode*> HierarchicalAStar::RefineSegment(GraphNode* pFromNode, GraphNode* pToNode)
+{
+	UpdateClusters();
+
+	const int fromNodeId{ pFromNode->GetId() };
+	const int toNodeId{ pToNode->GetId() };
+	const int clusterId{ GetClusterId(fromNodeId) };
+
+	// Exits step straight into the next cluster
+	if (clusterId != GetClusterId(toNodeId))
+		return HasConnection(fromNodeId, toNodeId) ? std::vector<GraphNode*>{ pFromNode, pToNode } : std::vector<GraphNode*>{};
+
+	const Cluster& cluster{ m_Clusters[clusterId] };
+	SearchCluster(cluster, fromNodeId, toNodeId, false, m_LocalCosts);
+	if (m_LocalCosts[GetLocalIndex(cluster, toNodeId)] == UNREACHABLE_COST)
+		return {};
+
+	std::vector<GraphNode*> path{};
+	for (int localIdx = GetLocalIndex(cluster, toNodeId); localIdx != invalid_node_id; localIdx = m_LocalParents[localIdx])
+	{
+		path.push_back(m_pGraph->GetNode(m_pGraph->GetNodeId(cluster.firstColumn + localIdx % cluster.nrOfColumns, cluster.firstRow + localIdx / cluster.nrOfColumns)));
+	}
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+
+int HierarchicalAStar::GetNrOfEntrances() const
+{
+	int nrOfEntrances{ 0 };
+	for (const Cluster& cluster : m_Clusters)
+	{
+		nrOfEntrances += static_cast<int>(cluster.entrances.size());
+	}
+	return nrOfEntrances;
+}
+
+// Rebuilds the clusters around the cells that changed since the last query, or all of them the first time
+void HierarchicalAStar::UpdateClusters()
+{
+	const DenseGrid& grid{ m_pGraph->GetDenseGrid() };
+	if (m_IsBuilt && m_GridRevision == grid.GetRevision())
+		return;
+
+	m_NrOfRebuiltClusters = 0;
+	m_ChangedNodeIds.clear();
+	if (!m_IsBuilt)
+	{
+		m_NrOfClusterColumns = (grid.GetColumns() + m_ClusterSize - 1) / m_ClusterSize;
+		m_NrOfClusterRows = (grid.GetRows() + m_ClusterSize - 1) / m_ClusterSize;
+		m_Clusters.resize(static_cast<size_t>(m_NrOfClusterColumns) * m_NrOfClusterRows);
+		for (int clusterId = 0; clusterId < static_cast<int>(m_Clusters.size()); ++clusterId)
+		{
+			Cluster& cluster{ m_Clusters[clusterId] };
+			cluster.firstColumn = clusterId % m_NrOfClusterColumns * m_ClusterSize;
+			cluster.firstRow = clusterId / m_NrOfClusterColumns * m_ClusterSize;
+			cluster.nrOfColumns = min(m_ClusterSize, grid.GetColumns() - cluster.firstColumn);
+			cluster.nrOfRows = min(m_ClusterSize, grid.GetRows() - cluster.firstRow);
+			cluster.isDirty = true;
+		}
+		m_EntranceIndices.assign(grid.GetNrOfCells(), invalid_node_id);
+	}
+	else if (grid.GetChangedCells(m_GridRevision, m_ChangedNodeIds))
+	{
+		for (int nodeId : m_ChangedNodeIds)
+		{
+			MarkClustersAroundCell(nodeId);
+		}
+	}
+	else
+	{
+		for (Cluster& cluster : m_Clusters)
+		{
+			cluster.isDirty = true;
+		}
+	}
+
+	// The entrances of a cluster only depend on its own borders, so every cluster can be rebuilt on its own
+	for (int clusterId = 0; clusterId < static_cast<int>(m_Clusters.size()); ++clusterId)
+	{
+		if (m_Clusters[clusterId].isDirty)
+			RebuildCluster(clusterId);
+	}
+
+	m_GridRevision = grid.GetRevision();
+	m_IsBuilt = true;
+}
+
+// A cell on the edge of its cluster also decides the crossings into the clusters on the other side of that edge
+void HierarchicalAStar::MarkClustersAroundCell(int nodeId)
+{
+	const auto [row, col] = m_pGraph->GetRowAndColumn(nodeId);
+	const int clusterCol{ col / m_ClusterSize };
+	const int clusterRow{ row / m_ClusterSize };
+	const int firstDeltaCol{ col % m_ClusterSize == 0 ? -1 : 0 };
+	const int lastDeltaCol{ col % m_ClusterSize == m_ClusterSize - 1 ? 1 : 0 };
+	const int firstDeltaRow{ row % m_ClusterSize == 0 ? -1 : 0 };
+	const int lastDeltaRow{ row % m_ClusterSize == m_ClusterSize - 1 ? 1 : 0 };
+
+	for (int deltaRow = firstDeltaRow; deltaRow <= lastDeltaRow; ++deltaRow)
+	{
+		for (int deltaCol = firstDeltaCol; deltaCol <= lastDeltaCol; ++deltaCol)
+		{
+			const int otherClusterCol{ clusterCol + deltaCol };
+			const int otherClusterRow{ clusterRow + deltaRow };
+			if (otherClusterCol >= 0 && otherClusterCol < m_NrOfClusterColumns && otherClusterRow >= 0 && otherClusterRow < m_NrOfClusterRows)
+				m_Clusters[otherClusterRow * m_NrOfClusterColumns + otherClusterCol].isDirty = true;
+		}
+	}
+}
+
+void HierarchicalAStar::RebuildCluster(int clusterId)
+{
+	const DenseGrid& grid{ m_pGraph->GetDenseGrid() };
+	Cluster& cluster{ m_Clusters[clusterId] };
+	for (const Entrance& entrance : cluster.entrances)
+	{
+		m_EntranceIndices[entrance.nodeId] = invalid_node_id;
+	}
+	cluster.entrances.clear();
+
+	// Both clusters of a border pick the same crossings, each one keeps the cells on its own side
+	const int clusterCol{ clusterId % m_NrOfClusterColumns };
+	const int clusterRow{ clusterId / m_NrOfClusterColumns };
+	for (const auto& offset : NEXT_CLUSTER_OFFSETS)
+	{
+		for (int side = -1; side <= 1; side += 2)
+		{
+			const int otherClusterCol{ clusterCol + offset[0] * side };
+			const int otherClusterRow{ clusterRow + offset[1] * side };
+			if (otherClusterCol < 0 || otherClusterCol >= m_NrOfClusterColumns || otherClusterRow < 0 || otherClusterRow >= m_NrOfClusterRows)
+				continue;
+
+			const int otherClusterId{ otherClusterRow * m_NrOfClusterColumns + otherClusterCol };
+			m_Crossings.clear();
+			if (side > 0)
+				AddBorderCrossings(clusterId, otherClusterId, m_Crossings);
+			else
+				AddBorderCrossings(otherClusterId, clusterId, m_Crossings);
+
+			for (const Crossing& crossing : m_Crossings)
+			{
+				const int nodeId{ side > 0 ? crossing.firstNodeId : crossing.secondNodeId };
+				const int otherNodeId{ side > 0 ? crossing.secondNodeId : crossing.firstNodeId };
+				const int entranceIdx{ GetOrAddEntrance(cluster, nodeId) };
+				if (HasConnection(nodeId, otherNodeId))
+				{
+					const int direction{ DenseGrid::GetDirection(otherNodeId % grid.GetColumns() - nodeId % grid.GetColumns(), otherNodeId / grid.GetColumns() - nodeId / grid.GetColumns()) };
+					cluster.entrances[entranceIdx].exits.push_back({ otherNodeId, grid.GetConnectionCost(nodeId, direction) });
+				}
+			}
+		}
+	}
+
+	const int nrOfEntrances{ static_cast<int>(cluster.entrances.size()) };
+	cluster.entranceCosts.assign(static_cast<size_t>(nrOfEntrances) * nrOfEntrances, UNREACHABLE_COST);
+	for (int fromEntranceIdx = 0; fromEntranceIdx < nrOfEntrances; ++fromEntranceIdx)
+	{
+		SearchCluster(cluster, cluster.entrances[fromEntranceIdx].nodeId, invalid_node_id, false, m_LocalCosts);
+		for (int toEntranceIdx = 0; toEntranceIdx < nrOfEntrances; ++toEntranceIdx)
+		{
+			cluster.entranceCosts[fromEntranceIdx * nrOfEntrances + toEntranceIdx] = m_LocalCosts[GetLocalIndex(cluster, cluster.entrances[toEntranceIdx].nodeId)];
+		}
+	}
+
+	cluster.isDirty = false;
+	++m_NrOfRebuiltClusters;
+}
+
+// A window is a run of border cells that cross straight both ways and are connected both ways to the next cell of the run,
+// on both sides. A path over any crossing inside of a window can move to the crossings picked for it: the one in the middle,
+// and for long windows also the ones at its ends. Every other crossing, straight or diagonal, is picked on its own.
+void HierarchicalAStar::AddBorderCrossings(int firstClusterId, int secondClusterId, std::vector<Crossing>& crossings)
+{
+	const Cluster& first{ m_Clusters[firstClusterId] };
+	const Cluster& second{ m_Clusters[secondClusterId] };
+	std::vector<int>& firstNodeIds{ m_FirstBorderNodeIds };
+	std::vector<int>& secondNodeIds{ m_SecondBorderNodeIds };
+	firstNodeIds.clear();
+	secondNodeIds.clear();
+
+	if (second.firstRow == first.firstRow)
+	{
+		// Second cluster on the right: the last column of the first one faces the first column of the second one
+		for (int row = first.firstRow; row < first.firstRow + first.nrOfRows; ++row)
+		{
+			firstNodeIds.push_back(m_pGraph->GetNodeId(first.firstColumn + first.nrOfColumns - 1, row));
+			secondNodeIds.push_back(m_pGraph->GetNodeId(second.firstColumn, row));
+		}
+	}
+	else if (second.firstColumn == first.firstColumn)
+	{
+		for (int col = first.firstColumn; col < first.firstColumn + first.nrOfColumns; ++col)
+		{
+			firstNodeIds.push_back(m_pGraph->GetNodeId(col, first.firstRow + first.nrOfRows - 1));
+			secondNodeIds.push_back(m_pGraph->GetNodeId(col, second.firstRow));
+		}
+	}
+	else
+	{
+		// Diagonal neighbours only touch in one corner
+		const bool isSecondOnTheRight{ second.firstColumn > first.firstColumn };
+		firstNodeIds.push_back(m_pGraph->GetNodeId(isSecondOnTheRight ? first.firstColumn + first.nrOfColumns - 1 : first.firstColumn, first.firstRow + first.nrOfRows - 1));
+		secondNodeIds.push_back(m_pGraph->GetNodeId(isSecondOnTheRight ? second.firstColumn : second.firstColumn + second.nrOfColumns - 1, second.firstRow));
+	}
+
+	// Start of the window every border cell is in, or invalid_node_id
+	const int nrOfBorderCells{ static_cast<int>(firstNodeIds.size()) };
+	std::vector<int>& windowStarts{ m_WindowStarts };
+	windowStarts.assign(nrOfBorderCells, invalid_node_id);
+	const bool isStraight{ nrOfBorderCells > 1 };
+	for (int idx = 0; idx < nrOfBorderCells && isStraight; ++idx)
+	{
+		if (!IsTwoWayConnection(firstNodeIds[idx], secondNodeIds[idx]))
+			continue;
+
+		const bool continuesWindow{ idx > 0 && windowStarts[idx - 1] != invalid_node_id
+			&& IsTwoWayConnection(firstNodeIds[idx - 1], firstNodeIds[idx]) && IsTwoWayConnection(secondNodeIds[idx - 1], secondNodeIds[idx]) };
+		windowStarts[idx] = continuesWindow ? windowStarts[idx - 1] : idx;
+	}
+
+	for (int idx = 0; idx < nrOfBorderCells; ++idx)
+	{
+		// Crossings picked for the window that ends here
+		const int windowStart{ windowStarts[idx] };
+		if (windowStart != invalid_node_id && (idx + 1 == nrOfBorderCells || windowStarts[idx + 1] != windowStart))
+		{
+			crossings.push_back({ firstNodeIds[(windowStart + idx) / 2], secondNodeIds[(windowStart + idx) / 2] });
+			if (idx - windowStart + 1 >= LONG_WINDOW_LENGTH)
+			{
+				crossings.push_back({ firstNodeIds[windowStart], secondNodeIds[windowStart] });
+				crossings.push_back({ firstNodeIds[idx], secondNodeIds[idx] });
+			}
+		}
+
+		for (int secondIdx = max(idx - 1, 0); secondIdx <= min(idx + 1, nrOfBorderCells - 1); ++secondIdx)
+		{
+			const bool isInWindow{ windowStart != invalid_node_id && windowStarts[secondIdx] == windowStart };
+			if (!isInWindow && (HasConnection(firstNodeIds[idx], secondNodeIds[secondIdx]) || HasConnection(secondNodeIds[secondIdx], firstNodeIds[idx])))
+				crossings.push_back({ firstNodeIds[idx], secondNodeIds[secondIdx] });
+		}
+	}
+}
+
+int HierarchicalAStar::GetOrAddEntrance(Cluster& cluster, int nodeId)
+{
+	if (m_EntranceIndices[nodeId] == invalid_node_id)
+	{
+		m_EntranceIndices[nodeId] = static_cast<int>(cluster.entrances.size());
+		cluster.entrances.push_back({ nodeId, {} });
+	}
+	return m_EntranceIndices[nodeId];
+}
+
+// Dijkstra over the cells of the cluster, from the source cell or, reversed, towards it.
+// Stops early once the target is reached, the parents of a forward search are left in m_LocalParents.
+void HierarchicalAStar::SearchCluster(const Cluster& cluster, int sourceNodeId, int targetNodeId, bool isReversed, std::vector<float>& costs)
+{
+	const DenseGrid& grid{ m_pGraph->GetDenseGrid() };
+	costs.assign(static_cast<size_t>(cluster.nrOfColumns) * cluster.nrOfRows, UNREACHABLE_COST);
+	m_LocalParents.assign(costs.size(), invalid_node_id);
+	m_OpenList.clear();
+
+	costs[GetLocalIndex(cluster, sourceNodeId)] = 0.f;
+	m_OpenList.push_back({ 0.f, sourceNodeId });
+
+	while (!m_OpenList.empty())
+	{
+		std::pop_heap(m_OpenList.begin(), m_OpenList.end(), std::greater<std::pair<float, int>>{});
+		const auto [cost, nodeId] = m_OpenList.back();
+		m_OpenList.pop_back();
+
+		const int localIdx{ GetLocalIndex(cluster, nodeId) };
+		if (cost != costs[localIdx])
+			continue;
+		if (nodeId == targetNodeId)
+			return;
+
+		const int localCol{ localIdx % cluster.nrOfColumns };
+		const int localRow{ localIdx / cluster.nrOfColumns };
+		for (int direction = 0; direction < DenseGrid::NR_OF_DIRECTIONS; ++direction)
+		{
+			const int neighborLocalCol{ localCol + DenseGrid::DIRECTION_OFFSETS[direction][0] };
+			const int neighborLocalRow{ localRow + DenseGrid::DIRECTION_OFFSETS[direction][1] };
+			if (neighborLocalCol < 0 || neighborLocalCol >= cluster.nrOfColumns || neighborLocalRow < 0 || neighborLocalRow >= cluster.nrOfRows)
+				continue;
+
+			const int neighborId{ nodeId + DenseGrid::DIRECTION_OFFSETS[direction][1] * grid.GetColumns() + DenseGrid::DIRECTION_OFFSETS[direction][0] };
+			const int oppositeDirection{ DenseGrid::OPPOSITE_DIRECTIONS[direction] };
+			if (isReversed ? !grid.HasConnection(neighborId, oppositeDirection) : !grid.HasConnection(nodeId, direction))
+				continue;
+
+			const float newCost{ cost + (isReversed ? grid.GetConnectionCost(neighborId, oppositeDirection) : grid.GetConnectionCost(nodeId, direction)) };
+			const int neighborLocalIdx{ neighborLocalRow * cluster.nrOfColumns + neighborLocalCol };
+			if (newCost < costs[neighborLocalIdx])
+			{
+				costs[neighborLocalIdx] = newCost;
+				m_LocalParents[neighborLocalIdx] = localIdx;
+				m_OpenList.push_back({ newCost, neighborId });
+				std::push_heap(m_OpenList.begin(), m_OpenList.end(), std::greater<std::pair<float, int>>{});
+			}
+		}
+	}
+}
+
+void HierarchicalAStar::AddSuccessor(SearchContext& context, int nodeId, int parentNodeId, float costSoFar, int goalNodeId) const
+{
+	if (context.IsVisited(nodeId) && context.GetRecord(nodeId).costSoFar <= costSoFar)
+		return;
+
+	SearchContext::NodeRecord& record{ context.IsVisited(nodeId) ? context.GetRecord(nodeId) : context.Visit(nodeId) };
+	record.parentNodeId = parentNodeId;
+	record.costSoFar = costSoFar;
+	record.estimatedTotalCost = costSoFar + GetHeuristicCost(nodeId, goalNodeId);
+	context.PushOrDecrease(nodeId);
+}
+
+// Octile distance with the costs of the grid, the cost between entrances is never lower than that
+float HierarchicalAStar::GetHeuristicCost(int fromNodeId, int toNodeId) const
+{
+	const DenseGrid& grid{ m_pGraph->GetDenseGrid() };
+	const auto [fromRow, fromCol] = m_pGraph->GetRowAndColumn(fromNodeId);
+	const auto [toRow, toCol] = m_pGraph->GetRowAndColumn(toNodeId);
+	const int deltaCol{ abs(toCol - fromCol) };
+	const int deltaRow{ abs(toRow - fromRow) };
+
+	const float costStraight{ grid.GetCostStraight() };
+	const float costDiagonal{ m_pGraph->IsConnectedDiagonally() ? min(grid.GetCostDiagonal(), 2.f * costStraight) : 2.f * costStraight };
+	return costStraight * static_cast<float>(max(deltaCol, deltaRow) - min(deltaCol, deltaRow)) + costDiagonal * static_cast<float>(min(deltaCol, deltaRow));
+}
+
+int HierarchicalAStar::GetClusterId(int nodeId) const
+{
+	const auto [row, col] = m_pGraph->GetRowAndColumn(nodeId);
+	return row / m_ClusterSize * m_NrOfClusterColumns + col / m_ClusterSize;
+}
+
+int HierarchicalAStar::GetLocalIndex(const Cluster& cluster, int nodeId) const
+{
+	const auto [row, col] = m_pGraph->GetRowAndColumn(nodeId);
+	return (row - cluster.firstRow) * cluster.nrOfColumns + col - cluster.firstColumn;
+}
+
+bool HierarchicalAStar::HasConnection(int fromNodeId, int toNodeId) const
+{
+	const DenseGrid& grid{ m_pGraph->GetDenseGrid() };
+	const int direction{ DenseGrid::GetDirection(toNodeId % grid.GetColumns() - fromNodeId % grid.GetColumns(), toNodeId / grid.GetColumns() - fromNodeId / grid.GetColumns()) };
+	return direction != invalid_node_id && grid.HasConnection(fromNodeId, direction);
+}
+
+bool HierarchicalAStar::IsTwoWayConnection(int nodeId, int otherNodeId) const
+{
+	return HasConnection(nodeId, otherNodeId) && HasConnection(otherNodeId, nodeId);
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <vector>
+#include <cfloat>
+#include "ESearchContext.h"
+
+namespace Elite
+{
+	class GridGraph;
+	class GraphNode;
+
+	// Hierarchical path-finding A* (HPA*) over a GridGraph. The grid is split into square clusters, the cells where two
+	// clusters connect become entrances and the cheapest path between every two entrances of a cluster is computed up front.
+	// A query searches over the entrances and fills in the cells between them afterwards, so its cost grows with the number
+	// of clusters on the way instead of with the number of cells. The paths are close to, but not always, the cheapest ones.
+	// Changes to the grid are picked up by the next query, which only rebuilds the clusters around the changed cells.
+	// The searches share the scratch memory of the object, so one object can't be used by several threads at once.
+	class HierarchicalAStar final
+	{
+	public:
+		HierarchicalAStar(const GridGraph* pGraph, int clusterSize = 10);
+
+		// Searches the entrances and refines every segment of the result
+		std::vector<GraphNode*> FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode);
+		// Only the start node, the entrances on the way and the destination node.
+		// Two consecutive nodes are in the same cluster or neighbours in two different clusters.
+		std::vector<GraphNode*> FindAbstractPath(GraphNode* pStartNode, GraphNode* pDestinationNode);
+		// The cells from one node of an abstract path to the next one, both included, so a path can be refined while it is followed.
+		// Empty when the grid changed and the segment can't be taken anymore.
+		std::vector<GraphNode*> RefineSegment(GraphNode* pFromNode, GraphNode* pToNode);
+
+		int GetClusterSize() const { return m_ClusterSize; }
+		int GetNrOfClusters() const { return static_cast<int>(m_Clusters.size()); }
+		int GetNrOfEntrances() const;
+		// Clusters rebuilt after the last change to the grid
+		int GetNrOfRebuiltClusters() const { return m_NrOfRebuiltClusters; }
+		// Nodes taken off the open heap by the last abstract search
+		int GetNrOfExpandedNodes() const { return m_NrOfExpandedNodes; }
+
+	private:
+		static constexpr float UNREACHABLE_COST{ FLT_MAX };
+		// Windows of at least this many border cells get a crossing at both ends on top of the one in the middle
+		static constexpr int LONG_WINDOW_LENGTH{ 6 };
+
+		// Pair of cells on both sides of the border between two clusters, the first one in the left or upper cluster
+		struct Crossing
+		{
+			int firstNodeId;
+			int secondNodeId;
+		};
+
+		// Connection from an entrance into the neighbouring cluster, it always leads to an entrance of that cluster
+		struct Exit
+		{
+			int toNodeId;
+			float cost;
+		};
+
+		struct Entrance
+		{
+			int nodeId;
+			std::vector<Exit> exits;
+		};
+
+		struct Cluster
+		{
+			int firstColumn;
+			int firstRow;
+			int nrOfColumns;
+			int nrOfRows;
+			std::vector<Entrance> entrances;
+			std::vector<float> entranceCosts; // From entrance i to entrance j at [i * nrOfEntrances + j], inside of the cluster
+			bool isDirty;
+		};
+
+		const GridGraph* m_pGraph;
+		int m_ClusterSize;
+		int m_NrOfClusterColumns{ 0 };
+		int m_NrOfClusterRows{ 0 };
+
+		unsigned int m_GridRevision{ 0 };
+		bool m_IsBuilt{ false };
+		std::vector<Cluster> m_Clusters{};
+		std::vector<int> m_EntranceIndices{}; // Per cell: index in the entrances of its cluster, or invalid_node_id
+
+		int m_NrOfRebuiltClusters{ 0 };
+		int m_NrOfExpandedNodes{ 0 };
+
+		// Scratch buffers, the local ones are indexed by the cell in the cluster
+		std::vector<int> m_ChangedNodeIds{};
+		std::vector<Crossing> m_Crossings{};
+		std::vector<int> m_FirstBorderNodeIds{};
+		std::vector<int> m_SecondBorderNodeIds{};
+		std::vector<int> m_WindowStarts{};
+		std::vector<float> m_LocalCosts{};
+		std::vector<float> m_StartCosts{};
+		std::vector<float> m_GoalCosts{};
+		std::vector<int> m_LocalParents{};
+		std::vector<std::pair<float, int>> m_OpenList{};
+
+		void UpdateClusters();
+		void MarkClustersAroundCell(int nodeId);
+		void RebuildCluster(int clusterId);
+		void AddBorderCrossings(int firstClusterId, int secondClusterId, std::vector<Crossing>& crossings);
+		int GetOrAddEntrance(Cluster& cluster, int nodeId);
+
+		void SearchCluster(const Cluster& cluster, int sourceNodeId, int targetNodeId, bool isReversed, std::vector<float>& costs);
+		void AddSuccessor(SearchContext& context, int nodeId, int parentNodeId, float costSoFar, int goalNodeId) const;
+		float GetHeuristicCost(int fromNodeId, int toNodeId) const;
+
+		int GetClusterId(int nodeId) const;
+		int GetLocalIndex(const Cluster& cluster, int nodeId) const;
+		bool HasConnection(int fromNodeId, int toNodeId) const;
+		bool IsTwoWayConnection(int nodeId, int otherNodeId) const;
+	};
+}
@@ -0,0 +1,336 @@
+#include "stdafx.h"
+#include "EJumpPointSearch.h"
+
+#include "../EliteGridGraph/EGridGraph.h"
+
+using namespace Elite;
+
+namespace
+{
+	// Straight directions a diagonal direction of the dense grid is made of
+	constexpr int STRAIGHT_COMPONENTS[DenseGrid::NR_OF_DIRECTIONS][2]{ {}, {}, {}, {}, { 0, 1 }, { 2, 1 }, { 2, 3 }, { 0, 3 } };
+
+	bool IsDiagonal(int direction) { return direction >= DenseGrid::NR_OF_DIRECTIONS / 2; }
+	int GetSign(int value) { return (value > 0) - (value < 0); }
+}
+
+JumpPointSearch::JumpPointSearch(const GridGraph* pGraph, bool usePrecomputedJumps)
+	: m_pGraph(pGraph)
+	, m_UsePrecomputedJumps(usePrecomputedJumps)
+{
+}
+
+std::vector<GraphNode*> JumpPointSearch::FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode)
+{
+	return FindPath(pStartNode, pDestinationNode, SearchContext::GetThreadContext());
+}
+
+std::vector<GraphNode*> JumpPointSearch::FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode, SearchContext& context)
+{
+	std::vector<GraphNode*> path{};
+	UpdateCellTypes();
+
+	const DenseGrid& grid{ m_pGraph->GetDenseGrid() };
+	const int startNodeId{ pStartNode->GetId() };
+	const int goalNodeId{ pDestinationNode->GetId() };
+	m_NrOfExpandedNodes = 0;
+
+	context.Reset(m_pGraph->GetNodeCapacity());
+	AddSuccessor(context, startNodeId, invalid_node_id, 0.f, goalNodeId);
+
+	while (!context.IsHeapEmpty())
+	{
+		const int nodeId{ context.PopCheapest() };
+		const SearchContext::NodeRecord record{ context.GetRecord(nodeId) };
+		++m_NrOfExpandedNodes;
+
+		if (nodeId == goalNodeId)
+		{
+			// Walk back over the jump points and fill in the cells that were jumped over
+			for (int toNodeId = goalNodeId; toNodeId != startNodeId; toNodeId = context.GetRecord(toNodeId).parentNodeId)
+			{
+				const int fromNodeId{ context.GetRecord(toNodeId).parentNodeId };
+				const auto [fromRow, fromCol] = m_pGraph->GetRowAndColumn(fromNodeId);
+				const auto [toRow, toCol] = m_pGraph->GetRowAndColumn(toNodeId);
+				const int deltaCol{ GetSign(fromCol - toCol) };
+				const int deltaRow{ GetSign(fromRow - toRow) };
+				for (int col = toCol, row = toRow; col != fromCol || row != fromRow; col += deltaCol, row += deltaRow)
+				{
+					path.push_back(m_pGraph->GetNode(m_pGraph->GetNodeId(col, row)));
+				}
+			}
+			path.push_back(pStartNode);
+			std::reverse(path.begin(), path.end());
+			return path;
+		}
+
+		if (m_CellTypes[nodeId] != CellType::Uniform)
+		{
+			// Next to other terrain or missing connections: expand every connection, like A*
+			for (int direction = 0; direction < DenseGrid::NR_OF_DIRECTIONS; ++direction)
+			{
+				if (grid.HasConnection(nodeId, direction))
+					AddSuccessor(context, grid.GetNeighborId(nodeId, direction), nodeId, record.costSoFar + grid.GetConnectionCost(nodeId, direction), goalNodeId);
+			}
+			continue;
+		}
+
+		if (record.parentNodeId == invalid_node_id)
+		{
+			// The start node jumps in every direction
+			for (int direction = 0; direction < DenseGrid::NR_OF_DIRECTIONS; ++direction)
+			{
+				AddJumpSuccessor(context, nodeId, record.costSoFar, direction, goalNodeId);
+			}
+			continue;
+		}
+
+		// Only the natural neighbours in the direction of travel and the forced ones can't be reached as cheap without this node
+		const auto [row, col] = m_pGraph->GetRowAndColumn(nodeId);
+		const auto [parentRow, parentCol] = m_pGraph->GetRowAndColumn(record.parentNodeId);
+		const int deltaCol{ GetSign(col - parentCol) };
+		const int deltaRow{ GetSign(row - parentRow) };
+		AddJumpSuccessor(context, nodeId, record.costSoFar, DenseGrid::GetDirection(deltaCol, deltaRow), goalNodeId);
+
+		if (deltaCol != 0 && deltaRow != 0)
+		{
+			AddJumpSuccessor(context, nodeId, record.costSoFar, DenseGrid::GetDirection(deltaCol, 0), goalNodeId);
+			AddJumpSuccessor(context, nodeId, record.costSoFar, DenseGrid::GetDirection(0, deltaRow), goalNodeId);
+			if (GetCellType(col - deltaCol, row) == CellType::Blocked)
+				AddJumpSuccessor(context, nodeId, record.costSoFar, DenseGrid::GetDirection(-deltaCol, deltaRow), goalNodeId);
+			if (GetCellType(col, row - deltaRow) == CellType::Blocked)
+				AddJumpSuccessor(context, nodeId, record.costSoFar, DenseGrid::GetDirection(deltaCol, -deltaRow), goalNodeId);
+		}
+		else
+		{
+			for (int side = -1; side <= 1; side += 2)
+			{
+				if (GetCellType(col + deltaRow * side, row + deltaCol * side) == CellType::Blocked)
+					AddJumpSuccessor(context, nodeId, record.costSoFar, DenseGrid::GetDirection(deltaCol + deltaRow * side, deltaRow + deltaCol * side), goalNodeId);
+			}
+		}
+	}
+
+	// If no path is found, return an empty path
+	return path;
+}
+
+void JumpPointSearch::UpdateCellTypes()
+{
+	const DenseGrid& grid{ m_pGraph->GetDenseGrid() };
+	if (m_IsUpToDate && m_GridRevision == grid.GetRevision())
+		return;
+
+	// Pruning only holds when a diagonal step is cheaper than two straight ones, but not cheaper than one
+	const bool canJump{ m_pGraph->IsConnectedDiagonally() && grid.GetCostDiagonal() >= grid.GetCostStraight() && grid.GetCostDiagonal() <= 2.f * grid.GetCostStraight() };
+
+	const int nrOfCells{ grid.GetNrOfCells() };
+	m_CellTypes.assign(nrOfCells, CellType::Blocked);
+	for (int nodeId = 0; nodeId < nrOfCells; ++nodeId)
+	{
+		if (!grid.IsPassable(nodeId))
+			continue;
+
+		// Open cells are ground with a connection to and from every neighbour that isn't blocked, all at the plain straight or diagonal cost
+		bool isOpen{ canJump && grid.GetTerrainType(nodeId) == TerrainType::Ground };
+		for (int direction = 0; direction < DenseGrid::NR_OF_DIRECTIONS && isOpen; ++direction)
+		{
+			const int neighborId{ grid.GetNeighborId(nodeId, direction) };
+			const bool isNeighborPassable{ neighborId != invalid_node_id && grid.IsPassable(neighborId) };
+			isOpen = grid.HasConnection(nodeId, direction) == isNeighborPassable
+				&& (!isNeighborPassable || (grid.HasConnection(neighborId, DenseGrid::OPPOSITE_DIRECTIONS[direction])
+					&& grid.GetConnectionCost(nodeId, direction) == (direction < 4 ? grid.GetCostStraight() : grid.GetCostDiagonal())));
+		}
+		m_CellTypes[nodeId] = isOpen ? CellType::Open : CellType::Irregular;
+	}
+
+	for (int nodeId = 0; nodeId < nrOfCells; ++nodeId)
+	{
+		if (m_CellTypes[nodeId] != CellType::Open)
+			continue;
+
+		bool isUniform{ true };
+		for (int direction = 0; direction < DenseGrid::NR_OF_DIRECTIONS && isUniform; ++direction)
+		{
+			const int neighborId{ grid.GetNeighborId(nodeId, direction) };
+			isUniform = neighborId == invalid_node_id || m_CellTypes[neighborId] != CellType::Irregular;
+		}
+		if (isUniform)
+			m_CellTypes[nodeId] = CellType::Uniform;
+	}
+
+	if (m_UsePrecomputedJumps)
+		BuildJumpDistances();
+
+	m_GridRevision = grid.GetRevision();
+	m_IsUpToDate = true;
+}
+
+// Every distance follows from the one of the next cell in the same direction, so each direction is one sweep against it.
+// The straight directions come first, the diagonal ones look them up.
+void JumpPointSearch::BuildJumpDistances()
+{
+	const int nrOfColumns{ m_pGraph->GetColumns() };
+	const int nrOfRows{ m_pGraph->GetRows() };
+	m_JumpDistances.assign(static_cast<size_t>(nrOfColumns) * nrOfRows * DenseGrid::NR_OF_DIRECTIONS, 0);
+
+	for (int direction = 0; direction < DenseGrid::NR_OF_DIRECTIONS; ++direction)
+	{
+		const int deltaCol{ DenseGrid::DIRECTION_OFFSETS[direction][0] };
+		const int deltaRow{ DenseGrid::DIRECTION_OFFSETS[direction][1] };
+		for (int rowIdx = 0; rowIdx < nrOfRows; ++rowIdx)
+		{
+			const int row{ deltaRow > 0 ? nrOfRows - 1 - rowIdx : rowIdx };
+			for (int colIdx = 0; colIdx < nrOfColumns; ++colIdx)
+			{
+				const int col{ deltaCol > 0 ? nrOfColumns - 1 - colIdx : colIdx };
+				if (GetCellType(col + deltaCol, row + deltaRow) == CellType::Blocked)
+					continue;
+
+				const int neighborId{ m_pGraph->GetNodeId(col + deltaCol, row + deltaRow) };
+				int& jumpDistance{ m_JumpDistances[m_pGraph->GetNodeId(col, row) * DenseGrid::NR_OF_DIRECTIONS + direction] };
+				if (IsJumpPoint(neighborId, direction, true))
+				{
+					jumpDistance = 1;
+				}
+				else
+				{
+					const int neighborJumpDistance{ m_JumpDistances[neighborId * DenseGrid::NR_OF_DIRECTIONS + direction] };
+					jumpDistance = neighborJumpDistance > 0 ? neighborJumpDistance + 1 : neighborJumpDistance - 1;
+				}
+			}
+		}
+	}
+}
+
+JumpPointSearch::CellType JumpPointSearch::GetCellType(int col, int row) const
+{
+	if (!m_pGraph->IsWithinBounds(col, row))
+		return CellType::Blocked;
+	return m_CellTypes[m_pGraph->GetNodeId(col, row)];
+}
+
+// A jump stops on cells it can't jump through, on cells with a forced neighbour,
+// and for diagonal jumps on cells from where a straight jump finds a jump point
+bool JumpPointSearch::IsJumpPoint(int nodeId, int direction, bool usePrecomputedJumps) const
+{
+	if (m_CellTypes[nodeId] != CellType::Uniform || HasForcedNeighbor(nodeId, direction))
+		return true;
+
+	if (!IsDiagonal(direction))
+		return false;
+
+	for (int straightDirection : STRAIGHT_COMPONENTS[direction])
+	{
+		const int jumpDistance{ usePrecomputedJumps ? m_JumpDistances[nodeId * DenseGrid::NR_OF_DIRECTIONS + straightDirection] : ScanJumpDistance(nodeId, straightDirection) };
+		if (jumpDistance > 0)
+			return true;
+	}
+	return false;
+}
+
+// A neighbour is forced when the blocked cell next to the path means it can only be reached optimally through this cell
+bool JumpPointSearch::HasForcedNeighbor(int nodeId, int direction) const
+{
+	const auto [row, col] = m_pGraph->GetRowAndColumn(nodeId);
+	const int deltaCol{ DenseGrid::DIRECTION_OFFSETS[direction][0] };
+	const int deltaRow{ DenseGrid::DIRECTION_OFFSETS[direction][1] };
+
+	if (IsDiagonal(direction))
+	{
+		return (GetCellType(col - deltaCol, row) == CellType::Blocked && GetCellType(col - deltaCol, row + deltaRow) != CellType::Blocked)
+			|| (GetCellType(col, row - deltaRow) == CellType::Blocked && GetCellType(col + deltaCol, row - deltaRow) != CellType::Blocked);
+	}
+
+	for (int side = -1; side <= 1; side += 2)
+	{
+		const int sideCol{ col + deltaRow * side };
+		const int sideRow{ row + deltaCol * side };
+		if (GetCellType(sideCol, sideRow) == CellType::Blocked && GetCellType(sideCol + deltaCol, sideRow + deltaRow) != CellType::Blocked)
+			return true;
+	}
+	return false;
+}
+
+int JumpPointSearch::GetJumpDistance(int nodeId, int direction) const
+{
+	return m_UsePrecomputedJumps ? m_JumpDistances[nodeId * DenseGrid::NR_OF_DIRECTIONS + direction] : ScanJumpDistance(nodeId, direction);
+}
+
+// Same result as the precomputed distances, found by walking the grid
+int JumpPointSearch::ScanJumpDistance(int nodeId, int direction) const
+{
+	auto [row, col] = m_pGraph->GetRowAndColumn(nodeId);
+	const int deltaCol{ DenseGrid::DIRECTION_OFFSETS[direction][0] };
+	const int deltaRow{ DenseGrid::DIRECTION_OFFSETS[direction][1] };
+
+	for (int steps = 1; ; ++steps)
+	{
+		col += deltaCol;
+		row += deltaRow;
+		if (GetCellType(col, row) == CellType::Blocked)
+			return 1 - steps;
+		if (IsJumpPoint(m_pGraph->GetNodeId(col, row), direction, false))
+			return steps;
+	}
+}
+
+// Jumps from a uniform cell. A goal on the way is a successor too, even when it isn't a jump point:
+// straight when it's on the line, diagonal when the jump crosses its row or column.
+void JumpPointSearch::AddJumpSuccessor(SearchContext& context, int nodeId, float costSoFar, int direction, int goalNodeId) const
+{
+	const int jumpDistance{ GetJumpDistance(nodeId, direction) };
+	const int deltaCol{ DenseGrid::DIRECTION_OFFSETS[direction][0] };
+	const int deltaRow{ DenseGrid::DIRECTION_OFFSETS[direction][1] };
+	const auto [row, col] = m_pGraph->GetRowAndColumn(nodeId);
+	const auto [goalRow, goalCol] = m_pGraph->GetRowAndColumn(goalNodeId);
+
+	int steps{ 0 };
+	if (IsDiagonal(direction))
+	{
+		if (GetSign(goalCol - col) == deltaCol && GetSign(goalRow - row) == deltaRow)
+			steps = min(abs(goalCol - col), abs(goalRow - row));
+	}
+	else if (deltaCol != 0 ? goalRow == row && GetSign(goalCol - col) == deltaCol : goalCol == col && GetSign(goalRow - row) == deltaRow)
+	{
+		steps = abs(goalCol - col) + abs(goalRow - row);
+	}
+
+	if (steps > abs(jumpDistance))
+		steps = 0;
+	if (steps == 0 && jumpDistance > 0)
+		steps = jumpDistance;
+	if (steps == 0)
+		return;
+
+	// Every step of a jump is between two open ground cells, so it has the plain straight or diagonal cost
+	const DenseGrid& grid{ m_pGraph->GetDenseGrid() };
+	const float stepCost{ IsDiagonal(direction) ? grid.GetCostDiagonal() : grid.GetCostStraight() };
+	AddSuccessor(context, m_pGraph->GetNodeId(col + deltaCol * steps, row + deltaRow * steps), nodeId, costSoFar + stepCost * steps, goalNodeId);
+}
+
+void JumpPointSearch::AddSuccessor(SearchContext& context, int nodeId, int parentNodeId, float costSoFar, int goalNodeId) const
+{
+	if (context.IsVisited(nodeId) && context.GetRecord(nodeId).costSoFar <= costSoFar)
+		return;
+
+	SearchContext::NodeRecord& record{ context.IsVisited(nodeId) ? context.GetRecord(nodeId) : context.Visit(nodeId) };
+	record.parentNodeId = parentNodeId;
+	record.costSoFar = costSoFar;
+	record.estimatedTotalCost = costSoFar + GetHeuristicCost(nodeId, goalNodeId);
+	context.PushOrDecrease(nodeId);
+}
+
+// Octile distance with the costs of the grid, diagonal steps never count for more than two straight ones
+float JumpPointSearch::GetHeuristicCost(int fromNodeId, int toNodeId) const
+{
+	const DenseGrid& grid{ m_pGraph->GetDenseGrid() };
+	const auto [fromRow, fromCol] = m_pGraph->GetRowAndColumn(fromNodeId);
+	const auto [toRow, toCol] = m_pGraph->GetRowAndColumn(toNodeId);
+	const int deltaCol{ abs(toCol - fromCol) };
+	const int deltaRow{ abs(toRow - fromRow) };
+
+	const float costStraight{ grid.GetCostStraight() };
+	const float costDiagonal{ m_pGraph->IsConnectedDiagonally() ? min(grid.GetCostDiagonal(), 2.f * costStraight) : 2.f * costStraight };
+	return costStraight * static_cast<float>(max(deltaCol, deltaRow) - min(deltaCol, deltaRow)) + costDiagonal * static_cast<float>(min(deltaCol, deltaRow));
+}
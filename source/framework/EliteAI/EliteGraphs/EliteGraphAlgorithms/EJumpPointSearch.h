@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "ESearchContext.h"
+
+namespace Elite
+{
+	class GridGraph;
+	class GraphNode;
+
+	// Jump point search on the dense grid of a diagonally connected GridGraph. In uniform regions (open ground whose
+	// connections are all there) only the nodes where the path can change direction are put on the open heap, everything
+	// in between is jumped over. Cells next to other terrain or edited connections are expanded like A* does, so paths
+	// over mud stay optimal. Gives paths of the same cost as AStar with an octile heuristic.
+	class JumpPointSearch
+	{
+	public:
+		// JPS+ looks the jumps up in a table per cell and direction, plain JPS scans for them during the search.
+		// The table and the cell types are rebuilt by the first search after the grid changed.
+		JumpPointSearch(const GridGraph* pGraph, bool usePrecomputedJumps = true);
+
+		// Searches with the context of the calling thread
+		std::vector<GraphNode*> FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode);
+		// Searches with the given context. The path holds every cell, not only the jump points.
+		std::vector<GraphNode*> FindPath(GraphNode* pStartNode, GraphNode* pDestinationNode, SearchContext& context);
+
+		// Nodes taken off the open heap by the last search
+		int GetNrOfExpandedNodes() const { return m_NrOfExpandedNodes; }
+
+	private:
+		enum class CellType : uint8_t
+		{
+			Blocked,	// No connection to or from any neighbour
+			Irregular,	// Other terrain than ground, or some of its connections are missing
+			Open,		// Ground with all its connections, but next to an irregular cell
+			Uniform		// Open, and so are all its neighbours (or they are blocked): safe to jump through
+		};
+
+		const GridGraph* m_pGraph;
+		bool m_UsePrecomputedJumps;
+
+		unsigned int m_GridRevision{ 0 };
+		bool m_IsUpToDate{ false };
+		std::vector<CellType> m_CellTypes{};
+
+		// Per cell and direction: > 0 steps to the next jump point, <= 0 minus the steps that can be taken before a blocked cell
+		std::vector<int> m_JumpDistances{};
+
+		int m_NrOfExpandedNodes{ 0 };
+
+		void UpdateCellTypes();
+		void BuildJumpDistances();
+		CellType GetCellType(int col, int row) const;
+		bool IsJumpPoint(int nodeId, int direction, bool usePrecomputedJumps) const;
+		bool HasForcedNeighbor(int nodeId, int direction) const;
+		int GetJumpDistance(int nodeId, int direction) const;
+		int ScanJumpDistance(int nodeId, int direction) const;
+
+		void AddJumpSuccessor(SearchContext& context, int nodeId, float costSoFar, int direction, int goalNodeId) const;
+		void AddSuccessor(SearchContext& context, int nodeId, int parentNodeId, float costSoFar, int goalNodeId) const;
+		float GetHeuristicCost(int fromNodeId, int toNodeId) const;
+	};
+}
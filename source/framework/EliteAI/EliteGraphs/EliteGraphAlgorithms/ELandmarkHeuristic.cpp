@@ -0,0 +1,201 @@
+#include "stdafx.h"
+#include "ELandmarkHeuristic.h"
+
+#include "../EliteGraph/EGraph.h"
+#include "../EliteGraph/EGraphCSR.h"
+
+using namespace Elite;
+
+LandmarkHeuristic::LandmarkHeuristic(const Graph* pGraph, int nrOfLandmarks)
+	: m_pGraph(pGraph)
+	, m_NrOfLandmarks(max(nrOfLandmarks, 1))
+{
+}
+
+void LandmarkHeuristic::Update()
+{
+	if (m_PendingTables.valid() && m_PendingTables.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		m_pTables = m_PendingTables.get();
+
+	// Tables that finished after the graph changed again are still published, GetCost ignores them until the next rebuild lands
+	if (!m_PendingTables.valid() && !IsUpToDate())
+		m_PendingTables = std::async(std::launch::async, &LandmarkHeuristic::BuildTables, m_pGraph->BuildCSR(), m_pGraph->IsDirectional(), m_NrOfLandmarks);
+}
+
+void LandmarkHeuristic::Build()
+{
+	if (m_PendingTables.valid())
+		m_PendingTables.get();
+
+	m_pTables = BuildTables(m_pGraph->BuildCSR(), m_pGraph->IsDirectional(), m_NrOfLandmarks);
+}
+
+// max over the landmarks of d(L, to) - d(L, from) and d(from, L) - d(to, L), both follow from the triangle inequality
+float LandmarkHeuristic::GetCost(int fromNodeId, int toNodeId) const
+{
+	const Tables* pTables{ m_pTables.get() };
+	if (pTables == nullptr || pTables->revision != m_pGraph->GetRevision() || fromNodeId >= pTables->nrOfNodes || toNodeId >= pTables->nrOfNodes)
+		return 0.f;
+
+	const size_t nrOfLandmarks{ pTables->landmarkNodeIds.size() };
+	const float* pFromDistances{ pTables->distancesFromLandmarks.data() + fromNodeId * nrOfLandmarks };
+	const float* pToDistances{ pTables->distancesFromLandmarks.data() + toNodeId * nrOfLandmarks };
+	const bool isDirectional{ !pTables->distancesToLandmarks.empty() };
+	const float* pFromDistancesToLandmarks{ isDirectional ? pTables->distancesToLandmarks.data() + fromNodeId * nrOfLandmarks : pFromDistances };
+	const float* pToDistancesToLandmarks{ isDirectional ? pTables->distancesToLandmarks.data() + toNodeId * nrOfLandmarks : pToDistances };
+
+	// Landmarks that can't reach one of both nodes say nothing about them
+	float cost{ 0.f };
+	for (size_t landmarkIdx = 0; landmarkIdx < nrOfLandmarks; ++landmarkIdx)
+	{
+		if (pFromDistances[landmarkIdx] != UNREACHABLE_COST && pToDistances[landmarkIdx] != UNREACHABLE_COST)
+			cost = max(cost, pToDistances[landmarkIdx] - pFromDistances[landmarkIdx]);
+		if (pFromDistancesToLandmarks[landmarkIdx] != UNREACHABLE_COST && pToDistancesToLandmarks[landmarkIdx] != UNREACHABLE_COST)
+			cost = max(cost, pFromDistancesToLandmarks[landmarkIdx] - pToDistancesToLandmarks[landmarkIdx]);
+	}
+	return cost;
+}
+
+bool LandmarkHeuristic::IsUpToDate() const
+{
+	return m_pTables != nullptr && m_pTables->revision == m_pGraph->GetRevision();
+}
+
+std::vector<int> LandmarkHeuristic::GetLandmarkNodeIds() const
+{
+	return m_pTables == nullptr ? std::vector<int>{} : m_pTables->landmarkNodeIds;
+}
+
+// Picks every next landmark as far as possible from the ones before it (farthest point selection), so they end up
+// spread over the edges of the map, behind the walls the geometric heuristics don't see
+std::unique_ptr<LandmarkHeuristic::Tables> LandmarkHeuristic::BuildTables(std::shared_ptr<const GraphCSR> pCSR, bool isDirectional, int nrOfLandmarks)
+{
+	const GraphCSR& csr{ *pCSR };
+	auto pTables = std::make_unique<Tables>();
+	pTables->revision = csr.revision;
+	pTables->nrOfNodes = csr.nrOfNodes;
+
+	// Start from the first node that has a connection, nodes without any (walls) can't be a landmark
+	int firstConnectedNodeId{ 0 };
+	while (firstConnectedNodeId < csr.nrOfNodes && !csr.HasConnections(firstConnectedNodeId))
+	{
+		++firstConnectedNodeId;
+	}
+	if (firstConnectedNodeId == csr.nrOfNodes)
+		return pTables;
+
+	// Reversed connections, for the distances to the landmarks
+	GraphCSR reversed{};
+	if (isDirectional)
+	{
+		reversed.nrOfNodes = csr.nrOfNodes;
+		reversed.connectionOffsets.assign(csr.nrOfNodes + 1, 0);
+		for (int toNodeId : csr.toNodeIds)
+		{
+			++reversed.connectionOffsets[toNodeId + 1];
+		}
+		for (int nodeId = 0; nodeId < csr.nrOfNodes; ++nodeId)
+		{
+			reversed.connectionOffsets[nodeId + 1] += reversed.connectionOffsets[nodeId];
+		}
+
+		std::vector<int> nextOffsets{ reversed.connectionOffsets.begin(), reversed.connectionOffsets.end() - 1 };
+		reversed.toNodeIds.resize(csr.toNodeIds.size());
+		reversed.costs.resize(csr.costs.size());
+		for (int nodeId = 0; nodeId < csr.nrOfNodes; ++nodeId)
+		{
+			for (int connectionIdx = csr.GetFirstConnection(nodeId); connectionIdx < csr.GetEndConnection(nodeId); ++connectionIdx)
+			{
+				const int reversedIdx{ nextOffsets[csr.toNodeIds[connectionIdx]]++ };
+				reversed.toNodeIds[reversedIdx] = nodeId;
+				reversed.costs[reversedIdx] = csr.costs[connectionIdx];
+			}
+		}
+	}
+
+	std::vector<float> distances{};
+	std::vector<float> closestLandmarkDistances(csr.nrOfNodes, UNREACHABLE_COST);
+	std::vector<std::vector<float>> distancesFromLandmarks{};
+	std::vector<std::vector<float>> distancesToLandmarks{};
+
+	SearchDistances(csr, firstConnectedNodeId, closestLandmarkDistances);
+	for (int landmarkIdx = 0; landmarkIdx < nrOfLandmarks; ++landmarkIdx)
+	{
+		int landmarkNodeId{ invalid_node_id };
+		float farthestDistance{ 0.f };
+		for (int nodeId = 0; nodeId < csr.nrOfNodes; ++nodeId)
+		{
+			if (closestLandmarkDistances[nodeId] != UNREACHABLE_COST && closestLandmarkDistances[nodeId] > farthestDistance)
+			{
+				farthestDistance = closestLandmarkDistances[nodeId];
+				landmarkNodeId = nodeId;
+			}
+		}
+		if (landmarkNodeId == invalid_node_id)
+			break;
+
+		// The first search only served to find the first landmark
+		if (landmarkIdx == 0)
+			closestLandmarkDistances.assign(csr.nrOfNodes, UNREACHABLE_COST);
+
+		SearchDistances(csr, landmarkNodeId, distances);
+		for (int nodeId = 0; nodeId < csr.nrOfNodes; ++nodeId)
+		{
+			closestLandmarkDistances[nodeId] = min(closestLandmarkDistances[nodeId], distances[nodeId]);
+		}
+		closestLandmarkDistances[landmarkNodeId] = 0.f;
+
+		pTables->landmarkNodeIds.push_back(landmarkNodeId);
+		distancesFromLandmarks.push_back(distances);
+		if (isDirectional)
+		{
+			SearchDistances(reversed, landmarkNodeId, distances);
+			distancesToLandmarks.push_back(distances);
+		}
+	}
+
+	// Interleave the landmarks per node, a lookup then touches one or two cache lines
+	const size_t nrOfFoundLandmarks{ pTables->landmarkNodeIds.size() };
+	pTables->distancesFromLandmarks.resize(csr.nrOfNodes * nrOfFoundLandmarks);
+	pTables->distancesToLandmarks.resize(isDirectional ? csr.nrOfNodes * nrOfFoundLandmarks : 0);
+	for (int nodeId = 0; nodeId < csr.nrOfNodes; ++nodeId)
+	{
+		for (size_t landmarkIdx = 0; landmarkIdx < nrOfFoundLandmarks; ++landmarkIdx)
+		{
+			pTables->distancesFromLandmarks[nodeId * nrOfFoundLandmarks + landmarkIdx] = distancesFromLandmarks[landmarkIdx][nodeId];
+			if (isDirectional)
+				pTables->distancesToLandmarks[nodeId * nrOfFoundLandmarks + landmarkIdx] = distancesToLandmarks[landmarkIdx][nodeId];
+		}
+	}
+	return pTables;
+}
+
+// Dijkstra over the whole snapshot
+void LandmarkHeuristic::SearchDistances(const GraphCSR& csr, int sourceNodeId, std::vector<float>& distances)
+{
+	distances.assign(csr.nrOfNodes, UNREACHABLE_COST);
+	std::vector<std::pair<float, int>> openList{ { 0.f, sourceNodeId } };
+	distances[sourceNodeId] = 0.f;
+
+	while (!openList.empty())
+	{
+		std::pop_heap(openList.begin(), openList.end(), std::greater<std::pair<float, int>>{});
+		const auto [distance, nodeId] = openList.back();
+		openList.pop_back();
+
+		if (distance != distances[nodeId])
+			continue;
+
+		for (int connectionIdx = csr.GetFirstConnection(nodeId); connectionIdx < csr.GetEndConnection(nodeId); ++connectionIdx)
+		{
+			const int toNodeId{ csr.toNodeIds[connectionIdx] };
+			const float newDistance{ distance + csr.costs[connectionIdx] };
+			if (newDistance < distances[toNodeId])
+			{
+				distances[toNodeId] = newDistance;
+				openList.push_back({ newDistance, toNodeId });
+				std::push_heap(openList.begin(), openList.end(), std::greater<std::pair<float, int>>{});
+			}
+		}
+	}
+}
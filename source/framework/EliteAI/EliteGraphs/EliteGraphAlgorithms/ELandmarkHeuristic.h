@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <future>
+#include <cfloat>
+
+namespace Elite
+{
+	class Graph;
+	struct GraphCSR;
+
+	// ALT heuristic (A*, landmarks and the triangle inequality). The distances from and to a few landmark nodes are stored
+	// for every node, and d(L, goal) - d(L, node) can never be more than the cost from the node to the goal. Unlike the
+	// geometric heuristics this bound knows about walls and expensive terrain, so A* expands far fewer nodes on maze-like maps.
+	// The tables are built on a worker thread from the CSR snapshot of the graph, and rebuilt when the graph changed.
+	class LandmarkHeuristic final
+	{
+	public:
+		explicit LandmarkHeuristic(const Graph* pGraph, int nrOfLandmarks = 8);
+		~LandmarkHeuristic() = default;
+
+		// Publishes finished tables and starts a rebuild when the graph changed since the current ones were built.
+		// Call it between edits to the graph, e.g. once per frame, on the thread that edits it.
+		void Update();
+		// Builds the tables right away on the calling thread
+		void Build();
+
+		// Lower bound on the cost from one node to the other. It is 0 while the tables are missing or outdated,
+		// outdated tables can overestimate after a connection was added or got cheaper.
+		// Searches can call it from any thread, as long as they don't run during Update.
+		float GetCost(int fromNodeId, int toNodeId) const;
+
+		bool IsUpToDate() const;
+		bool IsBuilding() const { return m_PendingTables.valid(); }
+		int GetNrOfLandmarks() const { return m_NrOfLandmarks; }
+		std::vector<int> GetLandmarkNodeIds() const;
+
+	private:
+		static constexpr float UNREACHABLE_COST{ FLT_MAX };
+
+		// Distances per node, all landmarks of a node next to each other. Undirected graphs don't store the distances to the landmarks.
+		struct Tables
+		{
+			unsigned int revision{ 0 };
+			int nrOfNodes{ 0 };
+			std::vector<int> landmarkNodeIds{};
+			std::vector<float> distancesFromLandmarks{};
+			std::vector<float> distancesToLandmarks{};
+		};
+
+		const Graph* m_pGraph;
+		int m_NrOfLandmarks;
+
+		std::unique_ptr<Tables> m_pTables{};
+		std::future<std::unique_ptr<Tables>> m_PendingTables{};
+
+		static std::unique_ptr<Tables> BuildTables(std::shared_ptr<const GraphCSR> pCSR, bool isDirectional, int nrOfLandmarks);
+		static void SearchDistances(const GraphCSR& csr, int sourceNodeId, std::vector<float>& distances);
+
+		LandmarkHeuristic(const LandmarkHeuristic&) = delete;
+		LandmarkHeuristic& operator=(const LandmarkHeuristic&) = delete;
+	};
+}
@@ -6,6 +6,11 @@
 using namespace Elite;
 
 std::vector<Vector2> NavMeshPathfinding::FindPath(Vector2 startPos, Vector2 endPos, NavGraph* pNavGraph, std::vector<Vector2>& debugNodePositions, std::vector<Portal>& debugPortals)
+{
+	return FindPath(startPos, endPos, pNavGraph, debugNodePositions, debugPortals, SearchContext::GetThreadContext());
+}
+
+std::vector<Vector2> NavMeshPathfinding::FindPath(Vector2 startPos, Vector2 endPos, NavGraph* pNavGraph, std::vector<Vector2>& debugNodePositions, std::vector<Portal>& debugPortals, SearchContext& context)
 {
 	// Create the path to return
 	std::vector<Vector2> finalPath;
@@ -24,12 +29,12 @@ std::vector<Vector2> NavMeshPathfinding::FindPath(Vector2 startPos, Vector2 endP
 		return finalPath;
 	}
 
-	// Clone the graph
-	auto clonedGraph = pNavGraph->Clone();
+	// Put the start and end positions on top of the graph, the graph itself stays untouched
+	GraphOverlay overlay{ pNavGraph };
 
-	// Create the start NavGraphNode and add to the cloned graph
+	// Create the start NavGraphNode and add it to the overlay
 	NavGraphNode* pStartNode = new NavGraphNode(-1, startPos);
-	clonedGraph->AddNode(pStartNode);
+	overlay.AddNode(pStartNode);
 
 	// Loop over all the edges of the startTriangle and add connections
 	for (int lineIdx : pStartTriangle->metaData.IndexLines)
@@ -38,17 +43,17 @@ std::vector<Vector2> NavMeshPathfinding::FindPath(Vector2 startPos, Vector2 endP
 		if (nodeIdx != invalid_node_id)
 		{
 			// Add a connection from the start node to the node on this edge
-			const auto* node = clonedGraph->GetNode(nodeIdx);
+			const auto* node = pNavGraph->GetNode(nodeIdx);
 			if (node)
 			{
-				clonedGraph->AddConnection(new GraphConnection(pStartNode->GetId(), nodeIdx, Elite::Distance(startPos, node->GetPosition())));
+				overlay.AddConnection(pStartNode->GetId(), nodeIdx, Elite::Distance(startPos, node->GetPosition()));
 			}
 		}
 	}
 
-	// Create the end NavGraphNode and add to the cloned graph
+	// Create the end NavGraphNode and add it to the overlay
 	NavGraphNode* pEndNode = new NavGraphNode(-1, endPos);
-	clonedGraph->AddNode(pEndNode);
+	overlay.AddNode(pEndNode);
 
 	// Loop over all the edges of the endTriangle and add connections
 	for (int lineIdx : pEndTriangle->metaData.IndexLines)
@@ -57,13 +62,16 @@ std::vector<Vector2> NavMeshPathfinding::FindPath(Vector2 startPos, Vector2 endP
 		if (nodeIdx != invalid_node_id)
 		{
 			// Add a connection from the node on this edge to the end node
-			const auto* node = clonedGraph->GetNode(nodeIdx);
-			clonedGraph->AddConnection(new GraphConnection(nodeIdx, pEndNode->GetId(), Elite::Distance(endPos, node->GetPosition())));
+			const auto* node = pNavGraph->GetNode(nodeIdx);
+			overlay.AddConnection(nodeIdx, pEndNode->GetId(), Elite::Distance(endPos, node->GetPosition()));
 		}
 	}
 
-	AStar pathfinder(clonedGraph.get(), HeuristicFunctions::Chebyshev);
-	const auto path{ pathfinder.FindPath(pStartNode, pEndNode) };
+	AStar<HeuristicPolicies::Chebyshev> pathfinder(&overlay, {});
+	const auto path{ pathfinder.FindPath(pStartNode, pEndNode, context) };
+
+	// No path between both triangles, there are no portals to look for
+	if (path.empty()) return finalPath;
 
 	for (const auto& node : path)
 	{
@@ -8,12 +8,14 @@
 namespace Elite
 {
 	class NavGraph;
+	class SearchContext;
 
 
 	class NavMeshPathfinding
 	{
 	public:
 		
+		static std::vector<Vector2> FindPath(Vector2 startPos, Vector2 endPos, NavGraph* pNavGraph, std::vector<Vector2>& debugNodePositions, std::vector<Portal>& debugPortals, SearchContext& context);
 		static std::vector<Vector2> FindPath(Vector2 startPos, Vector2 endPos, NavGraph* pNavGraph, std::vector<Vector2>& debugNodePositions, std::vector<Portal>& debugPortals);
 		static std::vector<Vector2> FindPath(Vector2 startPos, Vector2 endPos, NavGraph* pNavGraph)
 		{
@@ -0,0 +1,168 @@
+#include "stdafx.h"
+#include "EPathRequestQueue.h"
+
+#include "EAStar.h"
+#include "ENavGraphPathfinding.h"
+#include "framework/EliteAI/EliteGraphs/EliteNavGraph/ENavGraph.h"
+
+using namespace Elite;
+
+PathRequestQueue::PathRequestQueue(Graph* pGraph, unsigned int nrOfWorkers)
+	: m_pGraph(pGraph)
+	, m_ThreadPool(nrOfWorkers)
+{
+}
+
+PathRequestQueue::PathRequestQueue(GridGraph* pGraph, unsigned int nrOfWorkers)
+	: PathRequestQueue(static_cast<Graph*>(pGraph), nrOfWorkers)
+{
+	m_pGridGraph = pGraph;
+}
+
+PathRequestQueue::PathRequestQueue(NavGraph* pGraph, unsigned int nrOfWorkers)
+	: PathRequestQueue(static_cast<Graph*>(pGraph), nrOfWorkers)
+{
+	m_pNavGraph = pGraph;
+}
+
+int PathRequestQueue::Request(int startNodeId, int goalNodeId, Heuristic heuristic, int priority, Callback callback)
+{
+	std::lock_guard<std::mutex> lock{ m_RequestMutex };
+	const int requestId{ m_NextRequestId++ };
+	m_Requests.push_back({ requestId, startNodeId, goalNodeId, heuristic, priority, std::move(callback) });
+	std::push_heap(m_Requests.begin(), m_Requests.end(), HasLowerPriority);
+	return requestId;
+}
+
+std::future<PathRequestQueue::Path> PathRequestQueue::Request(int startNodeId, int goalNodeId, Heuristic heuristic, int priority)
+{
+	auto pPromise = std::make_shared<std::promise<Path>>();
+	std::future<Path> future{ pPromise->get_future() };
+	Request(startNodeId, goalNodeId, heuristic, priority, [pPromise](int, const Path& path) { pPromise->set_value(path); });
+	return future;
+}
+
+int PathRequestQueue::Request(const Vector2& startPos, const Vector2& goalPos, int priority, NavMeshCallback callback)
+{
+	assert(m_pNavGraph != nullptr && "PathRequestQueue::Request: position requests need a queue on a NavGraph");
+
+	std::lock_guard<std::mutex> lock{ m_RequestMutex };
+	const int requestId{ m_NextRequestId++ };
+	m_Requests.push_back({ requestId, invalid_node_id, invalid_node_id, nullptr, priority, nullptr, startPos, goalPos, std::move(callback) });
+	std::push_heap(m_Requests.begin(), m_Requests.end(), HasLowerPriority);
+	return requestId;
+}
+
+bool PathRequestQueue::Cancel(int requestId)
+{
+	std::lock_guard<std::mutex> lock{ m_RequestMutex };
+	auto it = std::find_if(m_Requests.begin(), m_Requests.end(), [requestId](const PathRequest& request) { return request.requestId == requestId; });
+	if (it == m_Requests.end())
+		return false;
+
+	m_Requests.erase(it);
+	std::make_heap(m_Requests.begin(), m_Requests.end(), HasLowerPriority);
+	return true;
+}
+
+void PathRequestQueue::Clear()
+{
+	std::lock_guard<std::mutex> lock{ m_RequestMutex };
+	m_Requests.clear();
+}
+
+void PathRequestQueue::Update(float budgetInMilliseconds)
+{
+	// Every result is delivered in the Update that solved it, so without requests there is nothing to do
+	if (GetNrOfPendingRequests() == 0)
+	{
+		m_NrOfSolvedRequests = 0;
+		return;
+	}
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<long long>(budgetInMilliseconds * 1000.f));
+	m_NrOfStartedRequests = 0;
+
+	// Every thread of the pool, the calling one included, keeps taking requests until the deadline
+	m_ThreadPool.ParallelFor(m_ThreadPool.GetNrOfThreads(), 1, [this, deadline](int, int) { SolveRequests(deadline); });
+	m_NrOfSolvedRequests = m_NrOfStartedRequests;
+
+	// The callbacks run on this thread, outside the lock, so they can make new requests
+	{
+		std::lock_guard<std::mutex> lock{ m_ResultMutex };
+		m_DeliveredResults.swap(m_Results);
+	}
+	for (PathResult& result : m_DeliveredResults)
+	{
+		if (result.callback)
+			result.callback(result.requestId, result.path);
+		else if (result.navMeshCallback)
+			result.navMeshCallback(result.requestId, result.navMeshPath);
+	}
+	m_DeliveredResults.clear();
+}
+
+int PathRequestQueue::GetNrOfPendingRequests() const
+{
+	std::lock_guard<std::mutex> lock{ m_RequestMutex };
+	return static_cast<int>(m_Requests.size());
+}
+
+bool PathRequestQueue::HasLowerPriority(const PathRequest& lhs, const PathRequest& rhs)
+{
+	if (lhs.priority != rhs.priority)
+		return lhs.priority < rhs.priority;
+	return lhs.requestId > rhs.requestId;
+}
+
+bool PathRequestQueue::PopRequest(PathRequest& request)
+{
+	std::lock_guard<std::mutex> lock{ m_RequestMutex };
+	if (m_Requests.empty())
+		return false;
+
+	std::pop_heap(m_Requests.begin(), m_Requests.end(), HasLowerPriority);
+	request = std::move(m_Requests.back());
+	m_Requests.pop_back();
+	return true;
+}
+
+void PathRequestQueue::SolveRequests(std::chrono::steady_clock::time_point deadline)
+{
+	SearchContext& context{ SearchContext::GetThreadContext() };
+	PathRequest request{};
+
+	// The first request of an Update is always taken, so a tiny budget still makes progress
+	while ((m_NrOfStartedRequests == 0 || std::chrono::steady_clock::now() < deadline) && PopRequest(request))
+	{
+		++m_NrOfStartedRequests;
+
+		// A query between positions puts its own start and goal nodes on the mesh, the NavGraph itself is only read
+		if (request.navMeshCallback)
+		{
+			NavMeshPath navMeshPath{};
+			navMeshPath.path = NavMeshPathfinding::FindPath(request.startPos, request.goalPos, m_pNavGraph, navMeshPath.nodePositions, navMeshPath.portals, context);
+
+			std::lock_guard<std::mutex> lock{ m_ResultMutex };
+			m_Results.push_back({ request.requestId, nullptr, {}, std::move(request.navMeshCallback), std::move(navMeshPath) });
+			continue;
+		}
+
+		Path path{};
+		GraphNode* pStartNode{ m_pGraph->GetNode(request.startNodeId) };
+		GraphNode* pGoalNode{ m_pGraph->GetNode(request.goalNodeId) };
+		if (pStartNode != nullptr && pGoalNode != nullptr && m_pGridGraph != nullptr)
+		{
+			AStar<Heuristic, GridNodePositions> pathfinder{ m_pGridGraph, request.heuristic, m_pLandmarkHeuristic };
+			path = pathfinder.FindPath(pStartNode, pGoalNode, context);
+		}
+		else if (pStartNode != nullptr && pGoalNode != nullptr)
+		{
+			AStar pathfinder{ m_pGraph, request.heuristic, m_pLandmarkHeuristic };
+			path = pathfinder.FindPath(pStartNode, pGoalNode, context);
+		}
+
+		std::lock_guard<std::mutex> lock{ m_ResultMutex };
+		m_Results.push_back({ request.requestId, std::move(request.callback), std::move(path) });
+	}
+}
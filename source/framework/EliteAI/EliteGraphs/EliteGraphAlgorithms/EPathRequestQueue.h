@@ -0,0 +1,115 @@
+#pragma once
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <functional>
+#include "EHeuristic.h"
+#include "EPathSmoothing.h"
+#include "framework/EliteHelpers/EThreadPool.h"
+
+namespace Elite
+{
+	class Graph;
+	class GridGraph;
+	class NavGraph;
+	class GraphNode;
+	class LandmarkHeuristic;
+
+	// Collects A* path requests from any thread and solves them in Update, on a thread pool and within a time budget,
+	// so the cost of a frame doesn't depend on how many agents asked for a path in it. Requests with a higher priority
+	// go first, equal priorities in the order they came in. Every thread searches with its own SearchContext.
+	class PathRequestQueue final
+	{
+	public:
+		using Path = std::vector<GraphNode*>;
+		using Callback = std::function<void(int requestId, const Path& path)>;
+
+		// The result of a query between two positions on a navigation mesh, see NavMeshPathfinding::FindPath
+		struct NavMeshPath
+		{
+			std::vector<Vector2> path;
+			std::vector<Vector2> nodePositions;
+			std::vector<Portal> portals;
+		};
+		using NavMeshCallback = std::function<void(int requestId, const NavMeshPath& path)>;
+
+		explicit PathRequestQueue(Graph* pGraph, unsigned int nrOfWorkers = ThreadPool::DefaultNrOfWorkers());
+		// On a grid the searches compute the node positions from the node ids instead of asking the graph for them
+		explicit PathRequestQueue(GridGraph* pGraph, unsigned int nrOfWorkers = ThreadPool::DefaultNrOfWorkers());
+		// Also takes requests between two positions, which are answered with the smoothed path over the mesh
+		explicit PathRequestQueue(NavGraph* pGraph, unsigned int nrOfWorkers = ThreadPool::DefaultNrOfWorkers());
+		~PathRequestQueue() = default;
+
+		// Both can be called from any thread. The callback is called from Update, the future is ready once Update delivered it.
+		// An empty path means there is none.
+		int Request(int startNodeId, int goalNodeId, Heuristic heuristic, int priority, Callback callback);
+		std::future<Path> Request(int startNodeId, int goalNodeId, Heuristic heuristic, int priority = 0);
+		// Only for a queue on a NavGraph. An empty path means there is none.
+		int Request(const Vector2& startPos, const Vector2& goalPos, int priority, NavMeshCallback callback);
+
+		// Landmarks every search combines with the heuristic of its request, nullptr for none. Only change it outside of Update.
+		void SetLandmarkHeuristic(const LandmarkHeuristic* pLandmarkHeuristic) { m_pLandmarkHeuristic = pLandmarkHeuristic; }
+
+		// Removes a request that wasn't solved yet, its callback is never called
+		bool Cancel(int requestId);
+		// Removes every pending request, e.g. when the graph was replaced
+		void Clear();
+
+		// Solves requests until the budget is used up, at least one per call, and delivers the results on the calling thread.
+		// The graph is only read during Update, so it can be edited in between. A search that started is always finished,
+		// so one long search can overrun the budget.
+		void Update(float budgetInMilliseconds);
+
+		int GetNrOfPendingRequests() const;
+		int GetNrOfSolvedRequests() const { return m_NrOfSolvedRequests; } // during the last Update
+
+	private:
+		struct PathRequest
+		{
+			int requestId;
+			int startNodeId;
+			int goalNodeId;
+			Heuristic heuristic;
+			int priority;
+			Callback callback;
+			Vector2 startPos{};
+			Vector2 goalPos{};
+			NavMeshCallback navMeshCallback{};
+		};
+
+		struct PathResult
+		{
+			int requestId;
+			Callback callback;
+			Path path;
+			NavMeshCallback navMeshCallback{};
+			NavMeshPath navMeshPath{};
+		};
+
+		Graph* m_pGraph;
+		const GridGraph* m_pGridGraph{ nullptr };
+		NavGraph* m_pNavGraph{ nullptr };
+		const LandmarkHeuristic* m_pLandmarkHeuristic{ nullptr };
+		ThreadPool m_ThreadPool;
+
+		// Pending requests as a max-heap on priority, then on request id
+		mutable std::mutex m_RequestMutex{};
+		std::vector<PathRequest> m_Requests{};
+		int m_NextRequestId{ 0 };
+
+		std::mutex m_ResultMutex{};
+		std::vector<PathResult> m_Results{};
+		std::vector<PathResult> m_DeliveredResults{};
+		std::atomic<int> m_NrOfStartedRequests{ 0 };
+		int m_NrOfSolvedRequests{ 0 };
+
+		static bool HasLowerPriority(const PathRequest& lhs, const PathRequest& rhs);
+		bool PopRequest(PathRequest& request);
+		void SolveRequests(std::chrono::steady_clock::time_point deadline);
+
+		PathRequestQueue(const PathRequestQueue&) = delete;
+		PathRequestQueue& operator=(const PathRequestQueue&) = delete;
+	};
+}
@@ -0,0 +1,128 @@
+#include "stdafx.h"
+#include "ESearchContext.h"
+
+using namespace Elite;
+
+SearchContext& SearchContext::GetThreadContext()
+{
+	thread_local SearchContext context{};
+	return context;
+}
+
+SearchContext& SearchContext::GetThreadBackwardContext()
+{
+	thread_local SearchContext context{};
+	return context;
+}
+
+// A new epoch makes every node unvisited at once, the epochs are only really cleared when the counter wraps around
+void SearchContext::Reset(int nodeCapacity)
+{
+	if (m_Records.size() < static_cast<size_t>(nodeCapacity))
+	{
+		m_Records.resize(nodeCapacity);
+		m_VisitEpochs.resize(nodeCapacity, 0);
+	}
+
+	if (++m_Epoch == 0)
+	{
+		std::fill(m_VisitEpochs.begin(), m_VisitEpochs.end(), 0);
+		m_Epoch = 1;
+	}
+
+	m_Queue.clear();
+	m_QueueFront = 0;
+	m_OpenHeap.clear();
+}
+
+SearchContext::NodeRecord& SearchContext::Visit(int nodeId)
+{
+	m_VisitEpochs[nodeId] = m_Epoch;
+	m_Records[nodeId] = NodeRecord{};
+	return m_Records[nodeId];
+}
+
+void SearchContext::PushOrDecrease(int nodeId)
+{
+	NodeRecord& record{ m_Records[nodeId] };
+	if (record.heapIndex == NOT_ON_HEAP)
+	{
+		record.heapIndex = static_cast<int>(m_OpenHeap.size());
+		m_OpenHeap.push_back(nodeId);
+	}
+
+	// The cost of a record only ever goes down, so it can only move up in the heap
+	SiftUp(record.heapIndex);
+}
+
+int SearchContext::PopCheapest()
+{
+	const int cheapestNodeId{ m_OpenHeap.front() };
+	m_Records[cheapestNodeId].heapIndex = NOT_ON_HEAP;
+
+	const int lastNodeId{ m_OpenHeap.back() };
+	m_OpenHeap.pop_back();
+	if (!m_OpenHeap.empty())
+	{
+		m_OpenHeap.front() = lastNodeId;
+		m_Records[lastNodeId].heapIndex = 0;
+		SiftDown(0);
+	}
+	return cheapestNodeId;
+}
+
+// Ties go to the record that got furthest, which is usually closer to the goal
+bool SearchContext::IsCheaper(int lhsNodeId, int rhsNodeId) const
+{
+	const NodeRecord& lhs{ m_Records[lhsNodeId] };
+	const NodeRecord& rhs{ m_Records[rhsNodeId] };
+	if (lhs.estimatedTotalCost != rhs.estimatedTotalCost)
+		return lhs.estimatedTotalCost < rhs.estimatedTotalCost;
+	return lhs.costSoFar > rhs.costSoFar;
+}
+
+void SearchContext::SiftUp(int heapIndex)
+{
+	const int nodeId{ m_OpenHeap[heapIndex] };
+	while (heapIndex > 0)
+	{
+		const int parentIndex{ (heapIndex - 1) / HEAP_ARITY };
+		if (!IsCheaper(nodeId, m_OpenHeap[parentIndex]))
+			break;
+
+		m_OpenHeap[heapIndex] = m_OpenHeap[parentIndex];
+		m_Records[m_OpenHeap[heapIndex]].heapIndex = heapIndex;
+		heapIndex = parentIndex;
+	}
+	m_OpenHeap[heapIndex] = nodeId;
+	m_Records[nodeId].heapIndex = heapIndex;
+}
+
+void SearchContext::SiftDown(int heapIndex)
+{
+	const int nodeId{ m_OpenHeap[heapIndex] };
+	const int heapSize{ static_cast<int>(m_OpenHeap.size()) };
+	while (true)
+	{
+		const int firstChildIndex{ heapIndex * HEAP_ARITY + 1 };
+		if (firstChildIndex >= heapSize)
+			break;
+
+		int cheapestChildIndex{ firstChildIndex };
+		const int endChildIndex{ min(firstChildIndex + HEAP_ARITY, heapSize) };
+		for (int childIndex = firstChildIndex + 1; childIndex < endChildIndex; ++childIndex)
+		{
+			if (IsCheaper(m_OpenHeap[childIndex], m_OpenHeap[cheapestChildIndex]))
+				cheapestChildIndex = childIndex;
+		}
+
+		if (!IsCheaper(m_OpenHeap[cheapestChildIndex], nodeId))
+			break;
+
+		m_OpenHeap[heapIndex] = m_OpenHeap[cheapestChildIndex];
+		m_Records[m_OpenHeap[heapIndex]].heapIndex = heapIndex;
+		heapIndex = cheapestChildIndex;
+	}
+	m_OpenHeap[heapIndex] = nodeId;
+	m_Records[nodeId].heapIndex = heapIndex;
+}
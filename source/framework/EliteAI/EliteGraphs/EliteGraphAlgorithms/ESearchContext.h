@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include "../EliteGraph/EGraphEnums.h"
+
+namespace Elite
+{
+	// Scratch memory of a graph search: per-node records, a FIFO queue and an indexed open heap.
+	// It only grows, and Reset makes every node unvisited in O(1) by moving to the next epoch,
+	// so repeated searches with the same context don't allocate. A context can only be used by one search at a time.
+	class SearchContext final
+	{
+	public:
+		// stores the cheapest known way to a node and its costs related to the start and end node of the path
+		struct NodeRecord
+		{
+			int parentNodeId = invalid_node_id; // node it was reached from, invalid_node_id for the start node
+			float costSoFar = 0.f; // accumulated g-costs of all the connections leading up to this one
+			float estimatedTotalCost = 0.f; // f-cost (= costSoFar + h-cost)
+			int heapIndex = NOT_ON_HEAP;
+		};
+
+		static constexpr int NOT_ON_HEAP{ -1 };
+
+		SearchContext() = default;
+		~SearchContext() = default;
+
+		// Context of the calling thread, used by the pathfinders when they aren't given one
+		static SearchContext& GetThreadContext();
+		// Second context of the calling thread, for the backward half of bidirectional searches
+		static SearchContext& GetThreadBackwardContext();
+
+		// Starts a new search over the node ids below nodeCapacity
+		void Reset(int nodeCapacity);
+
+		bool IsVisited(int nodeId) const { return m_VisitEpochs[nodeId] == m_Epoch; }
+		// Marks the node as visited with an empty record and returns that record
+		NodeRecord& Visit(int nodeId);
+		NodeRecord& GetRecord(int nodeId) { return m_Records[nodeId]; }
+		const NodeRecord& GetRecord(int nodeId) const { return m_Records[nodeId]; }
+
+		// FIFO queue, for breadth first searches
+		void PushBack(int nodeId) { m_Queue.push_back(nodeId); }
+		int PopFront() { return m_Queue[m_QueueFront++]; }
+		bool IsQueueEmpty() const { return m_QueueFront == m_Queue.size(); }
+		size_t GetQueueSize() const { return m_Queue.size() - m_QueueFront; }
+
+		// Min-heap of visited nodes on their estimated total cost. Pushing a node that is already on it
+		// moves it up after its cost went down (decrease-key).
+		void PushOrDecrease(int nodeId);
+		int PopCheapest();
+		bool IsHeapEmpty() const { return m_OpenHeap.empty(); }
+		size_t GetHeapSize() const { return m_OpenHeap.size(); }
+		// Node PopCheapest would return, without taking it off the heap
+		int GetCheapest() const { return m_OpenHeap.front(); }
+
+	private:
+		static constexpr int HEAP_ARITY{ 4 };
+
+		std::vector<NodeRecord> m_Records{};
+		std::vector<unsigned int> m_VisitEpochs{};
+		unsigned int m_Epoch{ 0 };
+
+		std::vector<int> m_Queue{};
+		size_t m_QueueFront{ 0 };
+		std::vector<int> m_OpenHeap{};
+
+		bool IsCheaper(int lhsNodeId, int rhsNodeId) const;
+		void SiftUp(int heapIndex);
+		void SiftDown(int heapIndex);
+
+		SearchContext(const SearchContext&) = delete;
+		SearchContext& operator=(const SearchContext&) = delete;
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <concepts>
 #include "../EliteGraph/EGraphNode.h"
+#include "../EliteGraph/EGraphArena.h"
 
 namespace Elite
 {
@@ -17,8 +18,10 @@ namespace Elite
 		GraphNodeFactory() = default;
 		virtual ~GraphNodeFactory() = default;
 
-		virtual GraphNode* CreateNode(const Elite::Vector2& pos) const = 0;
-		virtual GraphNode* CloneNode(const GraphNode& other) const = 0;
+		// The nodes live in the arena of the graph that asks for them
+		virtual GraphNode* CreateNode(const Elite::Vector2& pos, GraphArena& arena) const = 0;
+		virtual GraphNode* CloneNode(const GraphNode& other, GraphArena& arena) const = 0;
+		virtual void DestroyNode(GraphNode* pNode, GraphArena& arena) const = 0;
 	};
 
 	template<graphnodetype T_GraphNode>
@@ -28,8 +31,9 @@ namespace Elite
 		GraphNodeFactoryTemplate() = default;
 		virtual ~GraphNodeFactoryTemplate() = default;
 
-		GraphNode* CreateNode(const Elite::Vector2& pos) const  override { return new T_GraphNode(pos); }
-		GraphNode* CloneNode(const GraphNode& other) const  override { return  new T_GraphNode((const T_GraphNode&)other); }
+		GraphNode* CreateNode(const Elite::Vector2& pos, GraphArena& arena) const  override { return arena.Create<T_GraphNode>(pos); }
+		GraphNode* CloneNode(const GraphNode& other, GraphArena& arena) const  override { return arena.Create<T_GraphNode>((const T_GraphNode&)other); }
+		void DestroyNode(GraphNode* pNode, GraphArena& arena) const override { arena.Destroy(static_cast<T_GraphNode*>(pNode)); }
 	};
 
 	
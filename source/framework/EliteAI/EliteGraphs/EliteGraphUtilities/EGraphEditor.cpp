@@ -60,7 +60,7 @@ bool GraphEditor::UpdateGraph(Graph* pGraph)
 				{
 					if (pGraph->GetConnection(m_SelectedNodeIdx, clickedNodeIdx) == nullptr)
 					{
-						pGraph->AddConnection(new GraphConnection(m_SelectedNodeIdx, clickedNodeIdx));
+						pGraph->AddConnection(m_SelectedNodeIdx, clickedNodeIdx);
 						hasGraphChanged = true;
 					}
 				}
@@ -111,7 +111,7 @@ bool GraphEditor::UpdateGraph(Graph* pGraph)
 			DEBUGRENDERER2D->DrawCircle(nodePos, DEFAULT_NODE_RADIUS, { 1,1,1 }, -1);
 			if (m_mouseHasMoved)
 			{
-				pGraph->GetNode(m_SelectedNodeIdx)->SetPosition(m_MousePos);
+				pGraph->SetNodePosition(m_SelectedNodeIdx, m_MousePos);
 			}
 			hasGraphChanged = true;
 		}
@@ -0,0 +1,163 @@
+#include "stdafx.h"
+#include "EDenseGrid.h"
+
+using namespace Elite;
+
+DenseGrid::DenseGrid(int columns, int rows, float costStraight, float costDiagonal)
+	: m_NrOfColumns{ columns }
+	, m_NrOfRows{ rows }
+	, m_CostStraight{ costStraight }
+	, m_CostDiagonal{ costDiagonal }
+	, m_TerrainIndices(static_cast<size_t>(columns) * rows, 0)
+	, m_NeighborMasks(static_cast<size_t>(columns) * rows, 0)
+	, m_PassableBits((static_cast<size_t>(columns) * rows + 63) / 64, 0)
+	, m_ConnectionCosts(static_cast<size_t>(columns) * rows * NR_OF_DIRECTIONS, 0.f)
+{
+}
+
+void DenseGrid::SetTerrainType(int nodeId, TerrainType terrain)
+{
+	// Unknown terrain types count as ground
+	uint8_t terrainIdx{ 0 };
+	for (uint8_t idx = 0; idx < static_cast<uint8_t>(std::size(TERRAIN_TYPES)); ++idx)
+	{
+		if (TERRAIN_TYPES[idx] == terrain)
+			terrainIdx = idx;
+	}
+	m_TerrainIndices[nodeId] = terrainIdx;
+	++m_Revision;
+	LogChange(nodeId);
+}
+
+void DenseGrid::AddConnection(int fromNodeId, int toNodeId, float cost)
+{
+	// Only connections between neighbouring cells fit in the grid
+	const int direction{ GetDirectionBetween(fromNodeId, toNodeId) };
+	assert(direction != invalid_node_id && "<DenseGrid::AddConnection>: the nodes are not neighbours");
+	if (direction == invalid_node_id)
+		return;
+
+	m_NeighborMasks[fromNodeId] |= static_cast<uint8_t>(1 << direction);
+	m_ConnectionCosts[fromNodeId * NR_OF_DIRECTIONS + direction] = cost;
+
+	UpdatePassability(fromNodeId);
+	UpdatePassability(toNodeId);
+	++m_Revision;
+	LogChange(fromNodeId);
+	LogChange(toNodeId);
+}
+
+void DenseGrid::RemoveConnection(int fromNodeId, int toNodeId)
+{
+	const int direction{ GetDirectionBetween(fromNodeId, toNodeId) };
+	if (direction == invalid_node_id)
+		return;
+
+	m_NeighborMasks[fromNodeId] &= static_cast<uint8_t>(~(1 << direction));
+
+	UpdatePassability(fromNodeId);
+	UpdatePassability(toNodeId);
+	++m_Revision;
+	LogChange(fromNodeId);
+	LogChange(toNodeId);
+}
+
+void DenseGrid::SetConnectionCost(int fromNodeId, int toNodeId, float cost)
+{
+	const int direction{ GetDirectionBetween(fromNodeId, toNodeId) };
+	if (direction == invalid_node_id || m_ConnectionCosts[fromNodeId * NR_OF_DIRECTIONS + direction] == cost)
+		return;
+
+	m_ConnectionCosts[fromNodeId * NR_OF_DIRECTIONS + direction] = cost;
+	++m_Revision;
+	LogChange(fromNodeId);
+	LogChange(toNodeId);
+}
+
+bool DenseGrid::GetChangedCells(unsigned int sinceRevision, std::vector<int>& nodeIds) const
+{
+	if (sinceRevision < m_ChangeLogRevision)
+		return false;
+
+	for (auto it = m_ChangeLog.rbegin(); it != m_ChangeLog.rend() && it->revision > sinceRevision; ++it)
+	{
+		nodeIds.push_back(it->nodeId);
+	}
+	return true;
+}
+
+void DenseGrid::CopyCells(const DenseGrid& source, const std::vector<int>& nodeIds)
+{
+	assert(source.m_NrOfColumns == m_NrOfColumns && source.m_NrOfRows == m_NrOfRows);
+
+	for (int nodeId : nodeIds)
+	{
+		m_TerrainIndices[nodeId] = source.m_TerrainIndices[nodeId];
+		m_NeighborMasks[nodeId] = source.m_NeighborMasks[nodeId];
+		std::copy_n(source.m_ConnectionCosts.begin() + nodeId * NR_OF_DIRECTIONS, NR_OF_DIRECTIONS, m_ConnectionCosts.begin() + nodeId * NR_OF_DIRECTIONS);
+
+		const uint64_t passableBit{ uint64_t{ 1 } << (nodeId & 63) };
+		m_PassableBits[nodeId >> 6] = (m_PassableBits[nodeId >> 6] & ~passableBit) | (source.m_PassableBits[nodeId >> 6] & passableBit);
+	}
+
+	// The changes that led up to this revision are not known here
+	m_Revision = source.m_Revision;
+	m_ChangeLog.clear();
+	m_ChangeLogRevision = m_Revision;
+}
+
+int DenseGrid::GetNeighborId(int nodeId, int direction) const
+{
+	const int neighborCol{ nodeId % m_NrOfColumns + DIRECTION_OFFSETS[direction][0] };
+	const int neighborRow{ nodeId / m_NrOfColumns + DIRECTION_OFFSETS[direction][1] };
+	if (neighborCol < 0 || neighborCol >= m_NrOfColumns || neighborRow < 0 || neighborRow >= m_NrOfRows)
+		return invalid_node_id;
+
+	return neighborRow * m_NrOfColumns + neighborCol;
+}
+
+int DenseGrid::GetDirection(int deltaCol, int deltaRow)
+{
+	for (int direction = 0; direction < NR_OF_DIRECTIONS; ++direction)
+	{
+		if (DIRECTION_OFFSETS[direction][0] == deltaCol && DIRECTION_OFFSETS[direction][1] == deltaRow)
+			return direction;
+	}
+	return invalid_node_id;
+}
+
+size_t DenseGrid::GetMemorySize() const
+{
+	return sizeof(DenseGrid) + m_TerrainIndices.capacity() + m_NeighborMasks.capacity() + m_PassableBits.capacity() * sizeof(uint64_t)
+		+ m_ConnectionCosts.capacity() * sizeof(float) + m_ChangeLog.capacity() * sizeof(CellChange);
+}
+
+int DenseGrid::GetDirectionBetween(int fromNodeId, int toNodeId) const
+{
+	return GetDirection(toNodeId % m_NrOfColumns - fromNodeId % m_NrOfColumns, toNodeId / m_NrOfColumns - fromNodeId / m_NrOfColumns);
+}
+
+void DenseGrid::UpdatePassability(int nodeId)
+{
+	bool isPassable{ m_NeighborMasks[nodeId] != 0 };
+	for (int direction = 0; direction < NR_OF_DIRECTIONS && !isPassable; ++direction)
+	{
+		const int neighborId{ GetNeighborId(nodeId, direction) };
+		isPassable = neighborId != invalid_node_id && HasConnection(neighborId, OPPOSITE_DIRECTIONS[direction]);
+	}
+
+	if (isPassable)
+		m_PassableBits[nodeId >> 6] |= uint64_t{ 1 } << (nodeId & 63);
+	else
+		m_PassableBits[nodeId >> 6] &= ~(uint64_t{ 1 } << (nodeId & 63));
+}
+
+void DenseGrid::LogChange(int nodeId)
+{
+	if (m_ChangeLog.size() == MAX_CHANGE_LOG_SIZE)
+	{
+		m_ChangeLog.clear();
+		m_ChangeLogRevision = m_Revision;
+	}
+	m_ChangeLog.push_back({ m_Revision, nodeId });
+}
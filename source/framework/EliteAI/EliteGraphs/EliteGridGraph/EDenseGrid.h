@@ -0,0 +1,91 @@
+//*=================================================*/
+// EDenseGrid.h: flat structure-of-arrays view of a GridGraph. Terrain, passability and the outgoing connections
+// of every cell and their costs are packed in contiguous arrays, the neighbours follow from (col, row)
+//*=================================================*/
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "../EliteGraph/EGraphEnums.h"
+
+namespace Elite
+{
+	class DenseGrid final
+	{
+	public:
+		// Neighbour offsets (col, row): 4 straight directions followed by 4 diagonal directions, in the order GridGraph adds them
+		static constexpr int NR_OF_DIRECTIONS{ 8 };
+		static constexpr int DIRECTION_OFFSETS[NR_OF_DIRECTIONS][2]{ { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 }, { 1, 1 }, { -1, 1 }, { -1, -1 }, { 1, -1 } };
+		static constexpr int OPPOSITE_DIRECTIONS[NR_OF_DIRECTIONS]{ 2, 3, 0, 1, 6, 7, 4, 5 };
+
+		DenseGrid(int columns, int rows, float costStraight, float costDiagonal);
+		~DenseGrid() = default;
+
+		int GetColumns() const { return m_NrOfColumns; }
+		int GetRows() const { return m_NrOfRows; }
+		int GetNrOfCells() const { return m_NrOfColumns * m_NrOfRows; }
+		float GetCostStraight() const { return m_CostStraight; }
+		float GetCostDiagonal() const { return m_CostDiagonal; }
+
+		// Goes up on every change to the terrain or the connections, so data derived from the grid can tell it is outdated
+		unsigned int GetRevision() const { return m_Revision; }
+		// Adds the cells whose terrain or connections changed after the given revision. Only the latest changes are kept:
+		// returns false when they don't go back that far anymore, every cell has to be treated as changed then.
+		bool GetChangedCells(unsigned int sinceRevision, std::vector<int>& nodeIds) const;
+		// Brings a copy of a grid with the same size up to date with it, the given cells are the ones that changed since the copy.
+		// The copy takes over the revision of the source but not its change log.
+		void CopyCells(const DenseGrid& source, const std::vector<int>& nodeIds);
+
+		TerrainType GetTerrainType(int nodeId) const { return TERRAIN_TYPES[m_TerrainIndices[nodeId]]; }
+		void SetTerrainType(int nodeId, TerrainType terrain);
+
+		// A cell is passable when it has at least one connection to or from a neighbour
+		bool IsPassable(int nodeId) const { return (m_PassableBits[nodeId >> 6] >> (nodeId & 63)) & 1; }
+
+		// Bit d is set when the cell has a connection to its neighbour in direction d
+		uint8_t GetNeighborMask(int nodeId) const { return m_NeighborMasks[nodeId]; }
+		const uint8_t* GetNeighborMasks() const { return m_NeighborMasks.data(); }
+		bool HasConnection(int nodeId, int direction) const { return (m_NeighborMasks[nodeId] >> direction) & 1; }
+		void AddConnection(int fromNodeId, int toNodeId, float cost);
+		void RemoveConnection(int fromNodeId, int toNodeId);
+		void SetConnectionCost(int fromNodeId, int toNodeId, float cost);
+
+		int GetNeighborId(int nodeId, int direction) const;
+
+		// Cost of the connection of the graph, only meaningful when the connection exists
+		float GetConnectionCost(int nodeId, int direction) const { return m_ConnectionCosts[nodeId * NR_OF_DIRECTIONS + direction]; }
+
+		static int GetDirection(int deltaCol, int deltaRow);
+
+		size_t GetMemorySize() const;
+
+	private:
+		static constexpr TerrainType TERRAIN_TYPES[]{ TerrainType::Ground, TerrainType::Mud, TerrainType::Water };
+		static constexpr size_t MAX_CHANGE_LOG_SIZE{ 1024 };
+
+		struct CellChange
+		{
+			unsigned int revision;
+			int nodeId;
+		};
+
+		int m_NrOfColumns;
+		int m_NrOfRows;
+		float m_CostStraight;
+		float m_CostDiagonal;
+		unsigned int m_Revision{ 0 };
+
+		std::vector<uint8_t> m_TerrainIndices;
+		std::vector<uint8_t> m_NeighborMasks;
+		std::vector<uint64_t> m_PassableBits;
+		std::vector<float> m_ConnectionCosts; // Per cell and direction
+
+		// Latest changes, the ones up to m_ChangeLogRevision were dropped
+		std::vector<CellChange> m_ChangeLog{};
+		unsigned int m_ChangeLogRevision{ 0 };
+
+		int GetDirectionBetween(int fromNodeId, int toNodeId) const;
+		void UpdatePassability(int nodeId);
+		void LogChange(int nodeId);
+	};
+}
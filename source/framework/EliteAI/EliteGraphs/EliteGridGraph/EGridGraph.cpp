@@ -18,6 +18,7 @@ GridGraph::GridGraph(
 	float costDiagonal /* = 1.5f */,
 	GraphNodeFactory* pFactory, ConnectionCostCalculator* pCostCalculator)
 	: Graph(isDirectionalGraph, pFactory)
+	, m_DenseGrid(columns, rows, costStraight, costDiagonal)
 	, m_NrOfColumns(columns)
 	, m_NrOfRows(rows)
 	, m_CellSize(cellSize)
@@ -70,7 +71,7 @@ void Elite::GridGraph::AddConnectionsInDirections(int idx, int col, int row, std
 
 			if (!Graph::ConnectionExists(idx, neighborIdx)
 				&& connectionCost < 100000) //Extra check for different terrain types
-				AddConnection(new GraphConnection(idx, neighborIdx, connectionCost));
+				AddConnection(idx, neighborIdx, connectionCost);
 		}
 	}
 }
@@ -110,6 +111,28 @@ void GridGraph::AddConnectionsToAdjacentCells(int idx)
 	OnGraphModified(false, true);
 }
 
+// Refreshes the cost of every connection from and to the node, e.g. after its terrain type changed
+void GridGraph::RecalculateConnectionCosts(int idx)
+{
+	for (auto pConnection : GetConnectionsFromNode(idx))
+	{
+		SetConnectionCost(pConnection, CalculateConnectionCost(idx, pConnection->GetToNodeId()));
+	}
+
+	// Incoming connections don't need an outgoing one in a directional graph, so visit every neighbour
+	for (int direction = 0; direction < DenseGrid::NR_OF_DIRECTIONS; ++direction)
+	{
+		const int neighborIdx = m_DenseGrid.GetNeighborId(idx, direction);
+		if (neighborIdx == invalid_node_id || !m_DenseGrid.HasConnection(neighborIdx, DenseGrid::OPPOSITE_DIRECTIONS[direction]))
+			continue;
+
+		SetConnectionCost(GetConnection(neighborIdx, idx), CalculateConnectionCost(neighborIdx, idx));
+	}
+
+	++m_Revision;
+	OnGraphModified(false, false);
+}
+
 Vector2 Elite::GridGraph::GetNodePos(int nodeId) const
 {
 	auto [row, col] = GetRowAndColumn(nodeId);
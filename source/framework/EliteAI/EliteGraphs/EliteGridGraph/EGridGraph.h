@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../EliteGraph/EGraph.h"
+#include "EDenseGrid.h"
 namespace Elite
 {
 	
@@ -16,6 +17,7 @@ namespace Elite
 		virtual ~GridGraph();
 		int GetRows() const { return m_NrOfRows; }
 		int GetColumns() const { return m_NrOfColumns; }
+		bool IsConnectedDiagonally() const { return m_IsConnectedDiagonally; }
 
 		bool IsWithinBounds(int col, int row) const;
 		int GetNodeId(int col, int row) const { return row * m_NrOfColumns + col; }
@@ -28,8 +30,20 @@ namespace Elite
 
 		void AddConnectionsToAdjacentCells(int col, int row) { AddConnectionsToAdjacentCells(GetNodeId(col, row)); }
 		void AddConnectionsToAdjacentCells(int idx);
+		void RecalculateConnectionCosts(int idx);
 		Vector2 GetNodePos(int nodeId) const override;
 		std::pair<int, int> GetRowAndColumn(int idx) const { return { idx / m_NrOfColumns, idx % m_NrOfColumns }; }
+		float GetCellSize() const { return m_CellSize; }
+
+		// Flat copy of the terrain, connections and connection costs of every cell, kept in sync with the nodes and connections of the graph
+		const DenseGrid& GetDenseGrid() const { return m_DenseGrid; }
+
+	protected:
+		DenseGrid m_DenseGrid;
+
+		void OnConnectionAdded(int fromNodeId, int toNodeId, float cost) override { m_DenseGrid.AddConnection(fromNodeId, toNodeId, cost); }
+		void OnConnectionRemoved(int fromNodeId, int toNodeId) override { m_DenseGrid.RemoveConnection(fromNodeId, toNodeId); }
+		void OnConnectionCostChanged(int fromNodeId, int toNodeId, float cost) override { m_DenseGrid.SetConnectionCost(fromNodeId, toNodeId, cost); }
 
 	private:
 
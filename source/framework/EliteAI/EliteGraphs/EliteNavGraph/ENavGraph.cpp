@@ -34,6 +34,7 @@ NavGraph::NavGraph(const std::vector<Polygon>& colliderShapes, float widthWorld,
 }
 
 NavGraph::NavGraph(const NavGraph& other): Graph(other)
+	, m_NodeIdsPerLine(other.m_NodeIdsPerLine)
 {
 }
 
@@ -50,16 +51,11 @@ std::shared_ptr<NavGraph> NavGraph::Clone()
 
 int NavGraph::GetNodeIdFromLineIndex(int lineIdx) const
 {
+	if (lineIdx < 0 || lineIdx >= static_cast<int>(m_NodeIdsPerLine.size()))
+		return invalid_node_id;
 
-	for (auto& pNode : m_pNodes)
-	{
-		if (reinterpret_cast<NavGraphNode*>(pNode)->GetLineIndex() == lineIdx)
-		{
-			return pNode->GetId();
-		}
-	}
-
-	return invalid_node_id;
+	const int nodeId{ m_NodeIdsPerLine[lineIdx] };
+	return IsNodeValid(nodeId) ? nodeId : invalid_node_id;
 }
 
 Elite::Polygon* NavGraph::GetNavMeshPolygon() const
@@ -70,12 +66,14 @@ Elite::Polygon* NavGraph::GetNavMeshPolygon() const
 void NavGraph::CreateNavigationGraph()
 {
 	//1. Go over all the edges of the navigationmesh and create a node on the center of each edge
-	auto lines = m_pNavMeshPolygon->GetLines();
+	//   Only lines shared by two triangles get one, the others are on the border of the mesh
+	const auto& lines = m_pNavMeshPolygon->GetLines();
+	m_NodeIdsPerLine.assign(lines.size(), invalid_node_id);
 	for (const auto* line : lines)
 	{
 		if (m_pNavMeshPolygon->GetTrianglesFromLineIndex(line->index).size() == 2)
 		{
-			this->AddNode(new NavGraphNode(line->index, (line->p1 + line->p2) * 0.5f));
+			m_NodeIdsPerLine[line->index] = this->AddNode(new NavGraphNode(line->index, (line->p1 + line->p2) * 0.5f));
 		}
 	}
 
@@ -93,7 +91,7 @@ void NavGraph::CreateNavigationGraph()
 			const int nodeId = this->GetNodeIdFromLineIndex(lineIdx);
 
 			//2.2 Check if a valid NavGraphNode for that lineIdx exists
-			if (GetNodeIdFromLineIndex(lineIdx) != invalid_node_id)
+			if (nodeId != invalid_node_id)
 			{
 				tempValidNodes.emplace_back(nodeId);
 			}
@@ -103,14 +101,14 @@ void NavGraph::CreateNavigationGraph()
 			//	  If we have 3 valid nodes > we create 3 connections between them
 		if (tempValidNodes.size() == 2)
 		{
-			AddConnection(new GraphConnection(tempValidNodes[0], tempValidNodes[1]));
+			AddConnection(tempValidNodes[0], tempValidNodes[1]);
 
 		}
 		else if (tempValidNodes.size() == 3)
 		{
-			AddConnection(new GraphConnection(tempValidNodes[0], tempValidNodes[1]));
-			AddConnection(new GraphConnection(tempValidNodes[1], tempValidNodes[2]));
-			AddConnection(new GraphConnection(tempValidNodes[2], tempValidNodes[0]));
+			AddConnection(tempValidNodes[0], tempValidNodes[1]);
+			AddConnection(tempValidNodes[1], tempValidNodes[2]);
+			AddConnection(tempValidNodes[2], tempValidNodes[0]);
 		}
 
 	}
@@ -20,6 +20,7 @@ namespace Elite
 	private:
 		//--- Datamembers ---
 		Polygon* m_pNavMeshPolygon = nullptr; //Polygon that represents navigation mesh
+		std::vector<int> m_NodeIdsPerLine{}; //Node on each line of the navigation mesh, invalid_node_id for the lines without one
 
 		void CreateNavigationGraph();
 
@@ -12,12 +12,15 @@ namespace Elite
 		virtual ~TerrainGraphNode() = default;
 
 		TerrainType GetTerrainType() const { return m_Terrain; }
-		void SetTerrainType(TerrainType terrain);
 		const Color&  GetColor() const;
 
 
 	protected:
 		TerrainType m_Terrain;
+
+		// Use TerrainGridGraph::SetNodeTerrainType, the graph keeps a copy of the terrain types
+		friend class TerrainGridGraph;
+		void SetTerrainType(TerrainType terrain);
 	};
 
 }
\ No newline at end of file
@@ -20,9 +20,11 @@ TerrainGridGraph::~TerrainGridGraph()
 {
 }
 
-void TerrainGridGraph::SetNodeTerrainType(int nodeId, TerrainType type) const
+void TerrainGridGraph::SetNodeTerrainType(int nodeId, TerrainType type)
 {
 	auto node = reinterpret_cast<TerrainGraphNode*>(GetNode(nodeId));
 
 	node->SetTerrainType(type);
+	m_DenseGrid.SetTerrainType(nodeId, type);
+	++m_Revision;
 }
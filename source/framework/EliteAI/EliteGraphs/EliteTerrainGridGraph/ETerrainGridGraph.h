@@ -12,6 +12,6 @@ namespace Elite
 		TerrainGridGraph(int columns, int rows, float cellSize, bool isDirectionalGraph, bool isConnectedDiagonally, float costStraight = 1.f, float costDiagonal = 1.5);
 		virtual ~TerrainGridGraph();
 		
-		void SetNodeTerrainType(int node, TerrainType type)const;
+		void SetNodeTerrainType(int node, TerrainType type);
 	};
 }
\ No newline at end of file
@@ -211,28 +211,20 @@ std::vector<Elite::Triangle*> Elite::Polygon::GetAdjacentTrianglesOnLine(const T
 
 #ifdef USE_TRIANGLE_METADATA
 	//Start by getting index of line in matrix
-	auto lRev = Line(l.p2, l.p1);
-	const auto it = std::find_if(m_vpLines.begin(), m_vpLines.end(), [&](const Line* rl)
-		{
-			return (*rl == l || *rl == lRev);
-		});
-	if (it == m_vpLines.end())
+	const auto it = m_LineIndices.find(GetLineKey(l.p1, l.p2));
+	if (it == m_LineIndices.end())
 	{
 		std::cout << "WARNING: line not found!" << std::endl;
 		return adjTriangles;
 	}
-	const int lineIndex = it - m_vpLines.begin();
 
-	//Go over all the triangles and compare lines
-	for (auto ct : m_vpTriangles)
+	//Take the other triangles on that line from the line matrix
+	for (auto ct : m_vpTrianglesPerLine[it->second])
 	{
 		if (t == ct) //If same triangle, ignore
 			continue;
 
-		if (ct->metaData.IndexLines[0] == lineIndex
-			|| ct->metaData.IndexLines[1] == lineIndex
-			|| ct->metaData.IndexLines[2] == lineIndex)
-			adjTriangles.push_back(ct);
+		adjTriangles.push_back(ct);
 	}
 #endif
 	return adjTriangles;
@@ -252,17 +244,10 @@ const Elite::Triangle* Elite::Polygon::GetTriangleFromPosition(const Vector2& po
 #ifdef USE_TRIANGLE_METADATA
 const std::vector<const Elite::Triangle*> Elite::Polygon::GetTrianglesFromLineIndex(unsigned int lineIndex) const
 {
-	std::vector<const Triangle*> vpFoundTriangles = {};
-	for (auto pT : m_vpTriangles)
-	{
-		if (pT->metaData.IndexLines[0] == lineIndex ||
-			pT->metaData.IndexLines[1] == lineIndex ||
-			pT->metaData.IndexLines[2] == lineIndex)
-		{
-			vpFoundTriangles.push_back(pT);
-		}
-	}
-	return vpFoundTriangles;
+	//Filled in by GenerateLineMatrix
+	if (lineIndex >= m_vpTrianglesPerLine.size())
+		return {};
+	return { m_vpTrianglesPerLine[lineIndex].begin(), m_vpTrianglesPerLine[lineIndex].end() };
 }
 #endif
 
@@ -468,49 +453,39 @@ bool Elite::Polygon::IsEar(const list<Vector2>& l, const list<Vector2>::const_it
 void Elite::Polygon::GenerateLineMatrix()
 {
 #ifdef USE_TRIANGLE_METADATA
-	//Go over all the triangles
+	//Go over all the lines of all the triangles, add the ones that aren't in the matrix yet
+	//and store their index in the triangles meta data
 	for (auto t : m_vpTriangles)
 	{
-		//Go over all the lines of the triangle, search if they are already in the matrix
-		//If not add them and store it's index in the triangles meta data
-		const Line l1{ t->p1, t->p2 };
-		const Line l1rev{ t->p2, t->p1 };
-		const Line l2{ t->p2, t->p3 };
-		const Line l2rev{ t->p3, t->p2 };
-		const Line l3{ t->p3, t->p1 };
-		const Line l3rev{ t->p1, t->p3 };
-		for (auto i = 0; i < static_cast<int>(m_vpLines.size()); ++i)
-		{
-			const auto l = m_vpLines[i];
-			if (*l == l1 || *l == l1rev)
-				t->metaData.IndexLines[0] = i;
-			if (*l == l2 || *l == l2rev)
-				t->metaData.IndexLines[1] = i;
-			if (*l == l3 || *l == l3rev)
-				t->metaData.IndexLines[2] = i;
-		}
-		//Not found, add to matrix
-		if (t->metaData.IndexLines[0] == -1)
+		const std::array<Line, 3> triangleLines{ Line{ t->p1, t->p2 }, Line{ t->p2, t->p3 }, Line{ t->p3, t->p1 } };
+		for (size_t lineNr = 0; lineNr < triangleLines.size(); ++lineNr)
 		{
-			const int index = m_vpLines.size();
-			m_vpLines.push_back(new Line(t->p1, t->p2, index));
-			t->metaData.IndexLines[0] = index;
-		}
-		if (t->metaData.IndexLines[1] == -1)
-		{
-			const int index = m_vpLines.size();
-			m_vpLines.push_back(new Line(t->p2, t->p3, index));
-			t->metaData.IndexLines[1] = index;
-		}
-		if (t->metaData.IndexLines[2] == -1)
-		{
-			const int index = m_vpLines.size();
-			m_vpLines.push_back(new Line(t->p3, t->p1, index));
-			t->metaData.IndexLines[2] = index;
+			const auto& line = triangleLines[lineNr];
+			const auto insertResult = m_LineIndices.emplace(GetLineKey(line.p1, line.p2), static_cast<int>(m_vpLines.size()));
+			if (insertResult.second) //Not found, add to matrix
+				m_vpLines.push_back(new Line(line.p1, line.p2, insertResult.first->second));
+			t->metaData.IndexLines[lineNr] = insertResult.first->second;
 		}
 	}
+
+	//Store which triangles share each line, for GetTrianglesFromLineIndex
+	m_vpTrianglesPerLine.assign(m_vpLines.size(), {});
+	for (const auto t : m_vpTriangles)
+	{
+		for (const int lineIndex : t->metaData.IndexLines)
+			m_vpTrianglesPerLine[lineIndex].push_back(t);
+	}
 #endif
 }
+
+std::array<float, 4> Elite::Polygon::GetLineKey(const Vector2& p1, const Vector2& p2)
+{
+	//The lowest point goes first so both directions of a line give the same key.
+	//The vertices of the triangles are copies of the polygon points, so the points of a shared line have exactly the same values.
+	if (p1.x < p2.x || (p1.x == p2.x && p1.y < p2.y))
+		return { p1.x, p1.y, p2.x, p2.y };
+	return { p2.x, p2.y, p1.x, p1.y };
+}
 #pragma endregion //PrivateGeneralFunctions
 //----------------------------------------------------------
 #pragma region PrivateTriangulationFunctions
@@ -138,6 +138,8 @@ namespace Elite
 		std::list<Vector2> m_vPoints; //Points that define this polygon
 		std::vector<Triangle*> m_vpTriangles; //Triangles create for this polygon, used for rendering
 		std::vector<Line*> m_vpLines; //Lines constructing this polygon!
+		std::vector<std::vector<Triangle*>> m_vpTrianglesPerLine; //Triangles sharing each line, indexed like m_vpLines
+		std::map<std::array<float, 4>, int> m_LineIndices; //Index in m_vpLines of each line, keyed on its end points
 		bool m_isTriangulated = false;
 
 		//=== Functions ===
@@ -146,6 +148,7 @@ namespace Elite
 		bool IsConvexInPolygon(const std::list<Vector2>& l, const std::list<Vector2>::const_iterator p) const;
 		bool IsEar(const std::list<Vector2>& l, const std::list<Vector2>::const_iterator p) const;
 		void GenerateLineMatrix();
+		static std::array<float, 4> GetLineKey(const Vector2& p1, const Vector2& p2);
 
 		//Private Triangulation Functions
 		void FindMutualVisibleVertices(const Polygon& outer, const Polygon& inner, std::list<Vector2>::const_iterator& pOuter, std::list<Vector2>::const_iterator& pInner);
@@ -152,6 +152,24 @@ namespace Elite
 		}
 		return true;
 	}
+	/*! Check if a point is inside a closed shape of points - Even-Odd rule, so holes and self intersections flip the result */
+	template<typename container>
+	bool IsPointInPolygon(const Vector2& point, const container& shape)
+	{
+		bool isInside = false;
+		if (shape.empty())
+			return isInside;
+
+		auto previous = std::prev(shape.end());
+		for (auto current = shape.begin(); current != shape.end(); previous = current++)
+		{
+			//Does the horizontal ray to the right of the point cross this edge?
+			if ((current->y > point.y) != (previous->y > point.y)
+				&& point.x < (previous->x - current->x) * (point.y - current->y) / (previous->y - current->y) + current->x)
+				isInside = !isInside;
+		}
+		return isInside;
+	}
 	/*! Check if point is on a line */
 	inline auto IsPointOnLine(const Vector2& lineStart, const Vector2& lineEnd, const Vector2& point)
 	{
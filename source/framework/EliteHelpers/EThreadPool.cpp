@@ -0,0 +1,89 @@
+#include "stdafx.h"
+#include "EThreadPool.h"
+
+using namespace Elite;
+
+ThreadPool::ThreadPool(unsigned int nrOfWorkers)
+{
+	m_Workers.reserve(nrOfWorkers);
+	for (unsigned int workerIdx = 0; workerIdx < nrOfWorkers; ++workerIdx)
+	{
+		m_Workers.emplace_back(&ThreadPool::RunWorker, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_JobAvailable.notify_all();
+
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+}
+
+unsigned int ThreadPool::DefaultNrOfWorkers()
+{
+	const unsigned int nrOfCores{ std::thread::hardware_concurrency() };
+	return nrOfCores > 1 ? nrOfCores - 1 : 0;
+}
+
+void ThreadPool::Run(int count, int batchSize, BatchFunction pBatchFunction, void* pFunction)
+{
+	if (count <= 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_pBatchFunction = pBatchFunction;
+		m_pFunction = pFunction;
+		m_Count = count;
+		m_BatchSize = batchSize > 0 ? batchSize : 1;
+		m_NextBatch = 0;
+		m_NrOfBusyWorkers = static_cast<int>(m_Workers.size());
+		++m_JobId;
+	}
+	m_JobAvailable.notify_all();
+
+	ProcessBatches();
+
+	// The job data has to stay valid until every worker let go of it
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	m_JobDone.wait(lock, [this] { return m_NrOfBusyWorkers == 0; });
+}
+
+void ThreadPool::RunWorker()
+{
+	unsigned int lastJobId{ 0 };
+
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	while (true)
+	{
+		m_JobAvailable.wait(lock, [this, lastJobId] { return m_IsStopping || m_JobId != lastJobId; });
+		if (m_IsStopping)
+			return;
+
+		lastJobId = m_JobId;
+		lock.unlock();
+		ProcessBatches();
+		lock.lock();
+
+		if (--m_NrOfBusyWorkers == 0)
+			m_JobDone.notify_one();
+	}
+}
+
+void ThreadPool::ProcessBatches()
+{
+	const int nrOfBatches{ (m_Count + m_BatchSize - 1) / m_BatchSize };
+	for (int batchIdx = m_NextBatch++; batchIdx < nrOfBatches; batchIdx = m_NextBatch++)
+	{
+		const int begin{ batchIdx * m_BatchSize };
+		const int end{ begin + m_BatchSize < m_Count ? begin + m_BatchSize : m_Count };
+		m_pBatchFunction(m_pFunction, begin, end);
+	}
+}
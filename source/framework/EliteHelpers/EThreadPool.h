@@ -0,0 +1,67 @@
+/*=============================================================================*/
+// EThreadPool.h: fixed set of worker threads that split loops over an index range in batches.
+/*=============================================================================*/
+#ifndef ELITE_THREAD_POOL
+#define	ELITE_THREAD_POOL
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <type_traits>
+
+namespace Elite
+{
+	class ThreadPool final
+	{
+	public:
+		// The calling thread works along during ParallelFor, so by default there is one worker less than there are cores
+		explicit ThreadPool(unsigned int nrOfWorkers = DefaultNrOfWorkers());
+		~ThreadPool();
+
+		// Calls function(begin, end) for consecutive batches of at most batchSize indices in [0, count), spread over the
+		// workers and the calling thread. Returns when every batch is done. Nothing is allocated per call, so the function
+		// is only referenced while it runs. ParallelFor can't be called from inside a batch.
+		template<typename Function>
+		void ParallelFor(int count, int batchSize, Function&& function)
+		{
+			using FunctionType = std::remove_reference_t<Function>;
+			Run(count, batchSize,
+				[](void* pFunction, int begin, int end) { (*static_cast<FunctionType*>(pFunction))(begin, end); },
+				const_cast<void*>(static_cast<const void*>(&function)));
+		}
+
+		// Workers plus the calling thread
+		int GetNrOfThreads() const { return static_cast<int>(m_Workers.size()) + 1; }
+
+		static unsigned int DefaultNrOfWorkers();
+
+	private:
+		using BatchFunction = void(*)(void*, int, int);
+
+		std::vector<std::thread> m_Workers{};
+		std::mutex m_Mutex{};
+		std::condition_variable m_JobAvailable{};
+		std::condition_variable m_JobDone{};
+
+		// Current job, only changed while no worker is busy with it
+		BatchFunction m_pBatchFunction{ nullptr };
+		void* m_pFunction{ nullptr };
+		int m_Count{ 0 };
+		int m_BatchSize{ 1 };
+		std::atomic<int> m_NextBatch{ 0 };
+
+		unsigned int m_JobId{ 0 };
+		int m_NrOfBusyWorkers{ 0 };
+		bool m_IsStopping{ false };
+
+		void Run(int count, int batchSize, BatchFunction pBatchFunction, void* pFunction);
+		void RunWorker();
+		void ProcessBatches();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+	};
+}
+#endif
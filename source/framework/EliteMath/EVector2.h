@@ -20,7 +20,7 @@ namespace Elite
 
 		//=== Constructors ===
 		Vector2() = default;
-		Vector2(float _x, float _y) :x(_x), y(_y) {};
+		constexpr Vector2(float _x, float _y) :x(_x), y(_y) {};
 
 		//=== Vector Conversions Functions ===
 #ifdef USE_BOX2D
@@ -42,6 +42,7 @@ namespace Elite
 		void DrawDirection(const Elite::Vector2& p, const Elite::Vector2& dir, float length, const Color& color, float depth = 0.9f);
 		void DrawTransform(const Elite::Vector2& p, const Elite::Vector2& xAxis, const Elite::Vector2& yAxis, float depth);
 		void DrawPoint(const Elite::Vector2& p, float size, const Color& color, float depth = 0.9f);
+		void DrawPoints(const Elite::Vector2* points, int count, float size, const Color& color, float depth = 0.9f);
 		void DrawString(int x, int y, const char* string, ...) const;
 		void DrawString(const Elite::Vector2& pw, const char* string, ...) const;
 
@@ -416,6 +416,13 @@ void SDLDebugRenderer2D::DrawPoint(const Elite::Vector2& p, float size, const Co
 	m_vPoints.push_back(Vertex(p, depth, color, size));
 }
 
+void SDLDebugRenderer2D::DrawPoints(const Elite::Vector2* points, int count, float size, const Color& color, float depth)
+{
+	m_vPoints.reserve(m_vPoints.size() + count);
+	for (int i = 0; i < count; ++i)
+		m_vPoints.push_back(Vertex(points[i], depth, color, size));
+}
+
 void SDLDebugRenderer2D::DrawString(float worldPos_x, float worldPos_y, const char* string, ...) const
 {
 	auto screenPos = m_pActiveCamera->ConvertWorldToScreen({ worldPos_x	, worldPos_y });
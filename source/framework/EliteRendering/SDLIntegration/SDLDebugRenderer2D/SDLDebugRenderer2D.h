@@ -43,6 +43,7 @@ namespace Elite
 		void DrawDirection(const Elite::Vector2& p, const Elite::Vector2& dir, float length, const Color& color, float depth = 0.9f);
 		void DrawTransform(const Elite::Vector2& p, const Elite::Vector2& xAxis, const Elite::Vector2& yAxis, float depth);
 		void DrawPoint(const Elite::Vector2& p, float size, const Color& color, float depth = 0.9f);
+		void DrawPoints(const Elite::Vector2* points, int count, float size, const Color& color, float depth = 0.9f);
 		void DrawString(float worldPos_x, float worldPos_y, const char* string, ...) const;
 		void DrawString(const Elite::Vector2& worldPos, const char* string, ...) const;
 		void DrawString_ScreenSpace(const Elite::Vector2& screenPos, const char* string, ...) const;
@@ -4,13 +4,10 @@
 // Includes
 #include "App_FlowField.h"
 #include "framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/EAstar.h"
-#include "framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/EBFS.h"
+#include "framework/EliteAI/EliteGraphs/EliteGraph/EGraphConnection.h"
 #include "projects/Movement/SteeringBehaviors/PathFollow/PathFollowSteeringBehavior.h"
 #include "framework/EliteAI/EliteGraphs/EliteGraph/EGraphEnums.h"
 
-// Singletons
-#include "framework/EliteTimer/ETimer.h"
-
 // standardlibrary
 #include <algorithm>
 
@@ -33,8 +30,8 @@ void App_FlowField::Start()
 	//Create Graph
 	MakeGridGraph();
 
-	// HeatMap
-	InitializeHeatMap();
+	// HeatMap and vector field
+	ResetFields();
 
 	// World
 	m_WorldSize = { m_NrOfCols * static_cast<float>(m_SizeCell),m_NrOfRows * static_cast<float>(m_SizeCell) };
@@ -53,7 +50,7 @@ void App_FlowField::MakeGridGraph()
 }
 void App_FlowField::InitializeHeatMap()
 {
-	m_HeatMap.resize(m_NrOfCols * m_NrOfRows, 255); // Initialize with a high value
+	m_IntegrationField.Calculate(m_pTerrainGraph.get(), invalid_node_id); // Every cell starts unreachable
 	InitializeHeatMapPolygons();
 }
 void App_FlowField::InitializeHeatMapPolygons()
@@ -79,23 +76,17 @@ void App_FlowField::ResetAgents()
 	const float agentSafetyMargin = m_SizeCell * 0.5f;
 
 	// Clear existing agents, if any
-	m_vAgents.clear();
+	m_AgentPositions.clear();
+	m_AgentPositions.reserve(m_NrOfAgents);
 
 	// Create agents within the grid boundaries
 	for (int index = 0; index < m_NrOfAgents; ++index)
 	{
-		std::unique_ptr<SteeringAgent> pNewAgent = std::make_unique<SteeringAgent>();
-		pNewAgent->SetMaxLinearSpeed(25.f);
-		pNewAgent->SetMass(1.f); // A mass of 0 is unusual, setting it to 1
-		pNewAgent->SetAutoOrient(true);
-
 		Vector2 randomPos;
 		randomPos.x = static_cast<float>(rand() % static_cast<int>(m_WorldSize.x - agentSafetyMargin * 2)) + agentSafetyMargin;
 		randomPos.y = static_cast<float>(rand() % static_cast<int>(m_WorldSize.y - agentSafetyMargin * 2)) + agentSafetyMargin;
 
-		pNewAgent->SetPosition(randomPos);
-		pNewAgent->TrimToWorld(Elite::Vector2{}, Elite::Vector2{ m_NrOfCols * static_cast<float>(m_SizeCell), m_NrOfRows * static_cast<float>(m_SizeCell) }, false);
-		m_vAgents.emplace_back(std::move(pNewAgent));
+		m_AgentPositions.push_back(randomPos);
 	}
 }
 
@@ -103,13 +94,12 @@ void App_FlowField::ResetAgents()
 
 void App_FlowField::Update(float deltaTime)
 {
-	UNREFERENCED_PARAMETER(deltaTime);
-
 	// FlowField
 	HandleInput();
+	PublishFlowField();
 
 	// Update Agents
-	UpdateAgents();
+	UpdateAgents(deltaTime);
 
 	//IMGUI
 	UpdateImGui();
@@ -117,6 +107,7 @@ void App_FlowField::Update(float deltaTime)
 	// Update IMGUI Setting changes
 	UpdateAgentSettings();
 	UpdateGridSettings();
+	UpdateFlowFieldSettings();
 }
 void App_FlowField::HandleInput()
 {
@@ -130,9 +121,25 @@ void App_FlowField::HandleMiddleMouseButton()
 
 	Elite::Vector2 mousePos = GetMousePosition(InputMouseButton::eMiddle);
 	int nodeIndex = m_pTerrainGraph->GetNodeIdAtPosition(mousePos);
-	m_DestinationNodeIndex = nodeIndex;
-	CalculateHeatMap(nodeIndex);
-	CalculateVectorField();
+
+	if (m_bAddDestinations && nodeIndex != invalid_node_id)
+	{
+		// Toggle an extra destination
+		auto it = std::find(m_ExtraDestinationNodeIndices.begin(), m_ExtraDestinationNodeIndices.end(), nodeIndex);
+		if (it != m_ExtraDestinationNodeIndices.end())
+		{
+			m_ExtraDestinationNodeIndices.erase(it);
+		}
+		else
+		{
+			m_ExtraDestinationNodeIndices.push_back(nodeIndex);
+		}
+	}
+	else
+	{
+		m_DestinationNodeIndex = nodeIndex;
+	}
+	ReCalculateFlowField();
 }
 void App_FlowField::HandleLeftMouseButton()
 {
@@ -168,7 +175,18 @@ void App_FlowField::ToggleWallAtNode(TerrainGraphNode* node)
 			m_lWalls.erase(it);
 			wallExists = true;
 			m_pTerrainGraph->AddConnectionsToAdjacentCells(node->GetId());
-			ReCalculateFlowField();
+
+			// The graph is directional: the neighbours need their connection into this node back as well
+			for (auto pConnection : m_pTerrainGraph->GetConnectionsFromNode(node->GetId()))
+			{
+				int neighborIndex = pConnection->GetToNodeId();
+				if (!IsWallAtNode(neighborIndex) && !m_pTerrainGraph->ConnectionExists(neighborIndex, node->GetId()))
+				{
+					m_pTerrainGraph->AddConnection(neighborIndex, node->GetId(), pConnection->GetCost());
+				}
+			}
+
+			RepairFlowField(node->GetId());
 			break;
 		}
 	}
@@ -177,51 +195,80 @@ void App_FlowField::ToggleWallAtNode(TerrainGraphNode* node)
 	{
 		m_pTerrainGraph->RemoveAllConnectionsWithNode(node->GetId());
 		AddWall(node->GetPosition());
-		ReCalculateFlowField();
+		RepairFlowField(node->GetId());
 	}
 }
 void App_FlowField::ToggleTerrainTypeAtNode(TerrainGraphNode* node)
 {
 	if (node->GetTerrainType() == TerrainType::Mud)
 	{
-		node->SetTerrainType(TerrainType::Ground);
+		m_pTerrainGraph->SetNodeTerrainType(node->GetId(), TerrainType::Ground);
 	}
 	else
 	{
-		node->SetTerrainType(TerrainType::Mud);
+		m_pTerrainGraph->SetNodeTerrainType(node->GetId(), TerrainType::Mud);
 	}
-	ReCalculateFlowField();
+	m_pTerrainGraph->RecalculateConnectionCosts(node->GetId());
+	RepairFlowField(node->GetId());
 }
-void App_FlowField::UpdateAgents()
+bool App_FlowField::IsWallAtNode(int nodeIndex) const
 {
-	// Early exit if the destination index is invalid
-	if (m_DestinationNodeIndex == invalid_node_id) return;
+	Elite::Vector2 nodePosition = m_pTerrainGraph->GetNodePos(nodeIndex);
+	return std::any_of(m_lWalls.begin(), m_lWalls.end(),
+		[&](const std::unique_ptr<NavigationColliderElement>& wall) {
+			return wall->GetPosition() == nodePosition;
+		});
+}
+void App_FlowField::UpdateAgents(float deltaTime)
+{
+	// Early exit if there is no destination
+	if (!HasDestination()) return;
 
-	for (auto& pAgent : m_vAgents)
+	// Every agent only reads the flow field and writes its own slot, so the batches don't need any synchronisation
+	m_ThreadPool.ParallelFor(static_cast<int>(m_AgentPositions.size()), AGENT_BATCH_SIZE,
+		[this, deltaTime](int firstAgent, int endAgent) { UpdateAgentBatch(firstAgent, endAgent, deltaTime); });
+}
+void App_FlowField::UpdateAgentBatch(int firstAgent, int endAgent, float deltaTime)
+{
+	// Line of sight is only flagged with a single destination. The published field can still be the one of a previous
+	// destination while a new one is being built, so the destination is taken from the field itself.
+	const std::vector<IntegrationSeed>& seeds = m_IntegrationField.GetSeeds();
+	const Vector2 destinationPos = seeds.size() == 1 ? m_pTerrainGraph->GetNodePos(seeds[0].nodeId) : ZeroVector2;
+	const float inverseCellSize = 1.f / static_cast<float>(m_SizeCell);
+	const int nrOfCols = m_pTerrainGraph->GetColumns();
+	const int nrOfRows = m_pTerrainGraph->GetRows();
+
+	for (int agentIdx = firstAgent; agentIdx < endAgent; ++agentIdx)
 	{
-		if (pAgent == nullptr) continue;
-
-		// Get Agent's posiion
-		Vector2 agentPos = pAgent->GetPosition();
-
-		// Get node index based on agent's position
-		int nodeIndex = m_pTerrainGraph->GetNodeIdAtPosition(agentPos);
+		// Get node index based on agent's position, agents are clamped to the world so only the far edges need clamping
+		const Vector2 agentPos = m_AgentPositions[agentIdx];
+		const int col = min(static_cast<int>(agentPos.x * inverseCellSize), nrOfCols - 1);
+		const int row = min(static_cast<int>(agentPos.y * inverseCellSize), nrOfRows - 1);
+		const int nodeIndex = row * nrOfCols + col;
 
 		// Get direction from vector field
-		if (nodeIndex == invalid_node_id || nodeIndex == m_DestinationNodeIndex) continue;
-
-		Vector2 desiredDirection = m_VectorField[nodeIndex];
-		if (desiredDirection == ZeroVector2) continue; // Skip if there is no valid direction
+		Vector2 desiredDirection;
+		if (m_bUseSectors)
+		{
+			desiredDirection = m_SectorFlowField.GetDirection(nodeIndex);
+		}
+		else
+		{
+			// Decode the cell byte, with line of sight the agent heads straight for the destination instead of following the grid
+			const uint8_t cell = m_VectorField.GetCell(nodeIndex);
+			desiredDirection = FlowFieldCell::HasLineOfSight(cell) && !FlowFieldCell::IsGoal(cell)
+				? (destinationPos - agentPos).GetNormalized()
+				: FlowFieldCell::DECODE_TABLE[cell];
+		}
 
-		// Move agent in direction stored in vector field
-		Vector2 linearSpeed = desiredDirection.GetNormalized() * pAgent->GetMaxLinearSpeed();
-		pAgent->SetLinearVelocity(linearSpeed);
+		// Move agent in direction stored in vector field, agents without a direction stand still
+		const Vector2 linearSpeed = desiredDirection * m_AgentSpeed;
 
 		// Update the agent's position, clamping to world boundaries
-		Vector2 newPos = agentPos + linearSpeed * Elite::ETimer<PLATFORM_WINDOWS>::GetInstance()->GetElapsed();
+		Vector2 newPos = agentPos + linearSpeed * deltaTime;
 		newPos.x = Clamp(newPos.x, 0.f, m_WorldSize.x);
 		newPos.y = Clamp(newPos.y, 0.f, m_WorldSize.y);
-		pAgent->SetPosition(newPos);
+		m_AgentPositions[agentIdx] = newPos;
 	}
 }
 void App_FlowField::UpdateImGui()
@@ -253,6 +300,7 @@ void App_FlowField::UpdateImGui()
 		ImGui::Text("LMB: Add / Remove Wall");
 		ImGui::Text("RMB: Add / Remove Mud");
 		ImGui::Text("MMB: Set Destination");
+		ImGui::Checkbox("MMB adds destinations", &m_bAddDestinations);
 		ImGui::Unindent();
 
 		/*Spacing*/ImGui::Spacing(); ImGui::Separator(); ImGui::Spacing(); ImGui::Spacing();
@@ -261,6 +309,12 @@ void App_FlowField::UpdateImGui()
 		ImGui::Indent();
 		ImGui::Text("%.3f ms/frame", 1000.0f / ImGui::GetIO().Framerate);
 		ImGui::Text("%.1f FPS", ImGui::GetIO().Framerate);
+		if (m_bUseSectors) ImGui::Text("%d / %d sectors", m_SectorFlowField.GetNrOfActiveSectors(), m_SectorFlowField.GetNrOfSectors());
+		else
+		{
+			ImGui::Text("%d cached fields (%.1f MB)", m_FlowFieldCache.GetNrOfFields(), m_FlowFieldCache.GetMemoryUsage() / (1024.f * 1024.f));
+			ImGui::Text("field %u / %u", m_FlowFieldBuilder.GetPublishedGeneration(), m_FlowFieldBuilder.GetRequestedGeneration());
+		}
 		ImGui::Unindent();
 
 		/*Spacing*/ImGui::Spacing(); ImGui::Separator(); ImGui::Spacing(); ImGui::Spacing();
@@ -275,13 +329,17 @@ void App_FlowField::UpdateImGui()
 		ImGui::Text("FlowField");
 		ImGui::Checkbox("HeatMap", &m_bDrawHeatMap);
 		ImGui::Checkbox("VectorField", &m_bDrawVectorField);
+		ImGui::Checkbox("Agents", &m_bDrawAgents);
+		ImGui::Checkbox("Build in background", &m_bBuildInBackground);
+		ImGui::Checkbox("Sectors", &m_bUseSectors);
+		ImGui::SliderInt("SectorSize", &m_SectorSize, 5, 25);
 
 		ImGui::Text("Agent Settings");
-		ImGui::SliderInt("Agents", &m_NrOfAgents, 0, 2000);
+		ImGui::SliderInt("Agents", &m_NrOfAgents, 0, 100000);
 
 		ImGui::Text("Agent Settings");
-		ImGui::SliderInt("Columns", &m_NrOfCols, 10, 20);
-		ImGui::SliderInt("Rows", &m_NrOfRows, 10, 20);
+		ImGui::SliderInt("Columns", &m_NrOfCols, 10, MAX_GRID_SIZE);
+		ImGui::SliderInt("Rows", &m_NrOfRows, 10, MAX_GRID_SIZE);
 		ImGui::SliderInt("CellSize", &m_SizeCell, 20, 40);
 
 		ImGui::Spacing();
@@ -315,11 +373,26 @@ void App_FlowField::UpdateGridSettings()
 		m_WorldSize.y = static_cast<float>(m_SizeCell) * m_NrOfRows;
 	}
 }
+void App_FlowField::UpdateFlowFieldSettings()
+{
+	if (m_bUseSectors != m_PreviousUseSectors || m_SectorSize != m_PreviousSectorSize || m_bBuildInBackground != m_PreviousBuildInBackground)
+	{
+		m_IsSectorGraphDirty = true;
+		ReCalculateFlowField();
+
+		m_PreviousUseSectors = m_bUseSectors;
+		m_PreviousSectorSize = m_SectorSize;
+		m_PreviousBuildInBackground = m_bBuildInBackground;
+	}
+}
 void App_FlowField::UpdateAgentSettings()
 {
 	if (m_NrOfAgents != m_PreviousNrOfAgents)
 	{
 		ResetAgents();
+
+		// The new agents can be in sectors that aren't on a route yet
+		if (m_bUseSectors) ReCalculateSectorFlowField();
 	}
 
 	m_PreviousNrOfAgents = m_NrOfAgents;
@@ -341,54 +414,84 @@ void App_FlowField::Render(float deltaTime) const
 
 	RenderHeatMap();
 	RenderVectorField();
+	RenderAgents();
 
-	//Render destination node
-	if (m_DestinationNodeIndex != invalid_node_id)
+	//Render destination nodes
+	std::vector<Elite::GraphNode*> destinationNodes{};
+	for (const auto& seed : GetDestinationSeeds())
+	{
+		if (m_pTerrainGraph->IsNodeValid(seed.nodeId)) destinationNodes.push_back(m_pTerrainGraph->GetNode(seed.nodeId));
+	}
+	if (!destinationNodes.empty())
 	{
-		m_GraphRenderer.HighlightNodes(m_pTerrainGraph.get(), std::vector<Elite::GraphNode*>{ m_pTerrainGraph->GetNode(m_DestinationNodeIndex) }, END_NODE_COLOR);
+		m_GraphRenderer.HighlightNodes(m_pTerrainGraph.get(), destinationNodes, END_NODE_COLOR);
 	}
 
 }
+void App_FlowField::RenderAgents() const
+{
+	if (!m_bDrawAgents) return;
+
+	// All agents look the same, so they go to the renderer as one batch
+	DEBUGRENDERER2D->DrawPoints(m_AgentPositions.data(), static_cast<int>(m_AgentPositions.size()), 3.f, { 1, 1, 0, 1 }, 0.3f);
+}
 void App_FlowField::RenderHeatMap() const
 {
-	// Find the maximum heatmap value for normalization
-	int maxHeatmapValue = *std::max_element(m_HeatMap.begin(), m_HeatMap.end());
+	if (m_IntegrationField.GetCosts().size() != m_CellPolygons.size()) return;
 
 	// Render heatmap
 	if (m_bDrawHeatMap)
 	{
+		// Find the maximum heatmap value for normalization
+		float maxHeatmapValue = 0.f;
+		if (m_bUseSectors)
+		{
+			for (size_t idx = 0; idx < m_CellPolygons.size(); ++idx)
+			{
+				float heatmapValue = GetCostAtNode(static_cast<int>(idx));
+				if (heatmapValue != SectorFlowField::UNREACHABLE_COST) maxHeatmapValue = max(maxHeatmapValue, heatmapValue);
+			}
+		}
+		else
+		{
+			maxHeatmapValue = m_IntegrationField.GetHighestReachableCost();
+		}
+
 		Vector2 textPos{ 1.f, static_cast<float>(m_SizeCell) };
+		const bool drawValues{ m_CellPolygons.size() <= MAX_HEATMAP_VALUES };
 
 		for (size_t idx = 0; idx < m_CellPolygons.size(); ++idx)
 		{
 			// Get the heatmap value for the current cell
-			int heatmapValue = m_HeatMap[idx];
+			float heatmapValue = GetCostAtNode(static_cast<int>(idx));
+			bool isReachable = heatmapValue != IntegrationField::UNREACHABLE_COST;
 
 			// Map the heatmap value to a blue color
-			Elite::Color cellColor = ValueToColor(heatmapValue, maxHeatmapValue);
+			Elite::Color cellColor = ValueToColor(isReachable ? heatmapValue : 0.f, maxHeatmapValue);
 
 			// Draw color
 			DEBUGRENDERER2D->DrawSolidPolygon(m_CellPolygons[idx].get(), cellColor, -1.f, false);
 
-			// Draw heatmap values
+			// Draw heatmap values, on a large grid the text would only hide the colors
+			if (!drawValues) continue;
 			if (idx % m_NrOfCols == 0 && idx != 0)
 			{
 				textPos.y += m_SizeCell;
 				textPos.x = 1.f;
 			}
-			if (heatmapValue != invalid_node_id) DEBUGRENDERER2D->DrawString(textPos, std::to_string(heatmapValue).c_str());
+			if (isReachable) DEBUGRENDERER2D->DrawString(textPos, std::to_string(static_cast<int>(heatmapValue)).c_str());
 			textPos.x += m_SizeCell;
 		}
 	}
 }
 void App_FlowField::RenderVectorField() const
 {
-	if (m_DestinationNodeIndex == invalid_node_id) return;
+	if (!HasDestination()) return;
 	if (m_bDrawVectorField)
 	{
-		for (size_t nodeIndex = 0; nodeIndex < m_HeatMap.size(); ++nodeIndex)
+		for (size_t nodeIndex = 0; nodeIndex < m_VectorField.GetCells().size(); ++nodeIndex)
 		{
-			if (m_HeatMap[nodeIndex] == invalid_node_id)
+			if (GetCostAtNode(static_cast<int>(nodeIndex)) == IntegrationField::UNREACHABLE_COST)
 			{
 				continue; // Skip rendering non-traversable nodes
 			}
@@ -400,7 +503,7 @@ void App_FlowField::RenderVectorField() const
 			DEBUGRENDERER2D->DrawSolidCircle(nodePosition, 1.5f, Vector2{ 0, 0 }, { 1, 0, 0, 1 }, 0.4f);
 
 			// Get the vector direction
-			Vector2 vectorDirection = m_VectorField[nodeIndex];
+			Vector2 vectorDirection = GetDirectionAtNode(static_cast<int>(nodeIndex));
 
 			// Scale vector (visualisation)
 			Vector2 endPosition = nodePosition + vectorDirection * 7.5f;
@@ -414,81 +517,49 @@ void App_FlowField::RenderVectorField() const
 
 // Calculations
 
-void App_FlowField::CalculateHeatMap(int goalNodeIndex)
+void App_FlowField::CalculateHeatMap()
 {
-	//All nodes are unvisited
-	std::fill(m_HeatMap.begin(), m_HeatMap.end(), invalid_node_id);
-
-	// Create a pathfinder using Bread-First Search
-	BFS pathfinder(m_pTerrainGraph.get());
+	// One wavefront from all destinations gives every node the path cost to its nearest one, including the terrain costs of the connections
+	m_IntegrationField.Calculate(m_pTerrainGraph.get(), GetDestinationSeeds());
+}
+std::vector<IntegrationSeed> App_FlowField::GetDestinationSeeds() const
+{
+	std::vector<IntegrationSeed> seeds{};
+	seeds.reserve(m_ExtraDestinationNodeIndices.size() + 1);
 
-	// Iterate over all nodes
-	for (size_t nodeIndex = 0; nodeIndex < m_HeatMap.size(); ++nodeIndex)
+	if (m_DestinationNodeIndex != invalid_node_id) seeds.push_back({ m_DestinationNodeIndex });
+	for (int nodeIndex : m_ExtraDestinationNodeIndices)
 	{
-		// Skip the goal node
-		auto currentNode = static_cast<TerrainGraphNode*>(m_pTerrainGraph->GetNode(nodeIndex));
-		if (nodeIndex == goalNodeIndex)
-		{
-			m_HeatMap[nodeIndex] = (nodeIndex == goalNodeIndex) ? 0 : invalid_node_id;
-			continue;
-		}
-
-		// Find the path from the current node to the goal
-		auto path = pathfinder.FindPath(currentNode, m_pTerrainGraph->GetNode(goalNodeIndex));
-		if (!path.empty())
-		{
-			// Calculate and update the heatmap value for the node
-			m_HeatMap[nodeIndex] = path.size() - 1;
-			if (currentNode->GetTerrainType() == TerrainType::Mud)
-			{
-				m_HeatMap[nodeIndex] += static_cast<int>(TerrainType::Mud); // Extra cost for mud
-			}
-		}
+		seeds.push_back({ nodeIndex });
 	}
+	return seeds;
+}
+bool App_FlowField::HasDestination() const
+{
+	return m_DestinationNodeIndex != invalid_node_id || !m_ExtraDestinationNodeIndices.empty();
+}
+bool App_FlowField::HasSingleDestination() const
+{
+	return m_DestinationNodeIndex != invalid_node_id && m_ExtraDestinationNodeIndices.empty();
 }
 void App_FlowField::CalculateVectorField()
 {
-	m_VectorField.resize(m_HeatMap.size());
+	// Every direction only depends on the costs of the node's neighbours, so the whole field is generated in SIMD blocks
+	m_VectorField.Calculate(m_pTerrainGraph.get(), m_IntegrationField.GetCosts(), m_pTerrainGraph->IsConnectedDiagonally());
 
-	for (size_t nodeIndex = 0; nodeIndex < m_HeatMap.size(); ++nodeIndex)
+	// Agents with line of sight walk straight to the destination, only tracked when there is a single one
+	if (HasSingleDestination())
 	{
-		// Skip the goal node and non-traversable nodes
-		if (nodeIndex == m_DestinationNodeIndex || m_HeatMap[nodeIndex] == invalid_node_id)
-		{
-			m_VectorField[nodeIndex] = Elite::Vector2();
-			continue;
-		}
-
-		// Retrieve all neighbors
-		const auto& neighbors = m_pTerrainGraph->GetConnectionsFromNode(nodeIndex);
-
-		// Find the neighbor with the lowest heatmap value
-		float lowestCost = FLT_MAX;
-		Elite::Vector2 directionToLowestCostNeighbor;
-
-		for (const auto& neighbor : neighbors)
-		{
-			int neighborIndex = neighbor->GetToNodeId();
-			float neighborCost = static_cast<float>(m_HeatMap[neighborIndex]);
-
-			if (neighborCost < lowestCost)
-			{
-				lowestCost = neighborCost;
-				directionToLowestCostNeighbor = (m_pTerrainGraph->GetNodePos(neighborIndex) - m_pTerrainGraph->GetNodePos(nodeIndex)).GetNormalized();
-			}
-		}
-
-		// Assign the direction to the vector field
-		m_VectorField[nodeIndex] = directionToLowestCostNeighbor;
+		m_VectorField.CalculateLineOfSight(m_pTerrainGraph.get(), m_DestinationNodeIndex);
 	}
 }
 
 // Helper functions
 
-Elite::Color App_FlowField::ValueToColor(int value, int maxHeatmapValue) const
+Elite::Color App_FlowField::ValueToColor(float value, float maxHeatmapValue) const
 {
 	// Normalize
-	float normalizedValue = static_cast<float>(value) / maxHeatmapValue;
+	float normalizedValue = maxHeatmapValue > 0.f ? value / maxHeatmapValue : 0.f;
 
 	// Create a shade of blue based on the normalized value
 	return Elite::Color(0.0f, 0.0f, 1 - normalizedValue, 1.0f); 
@@ -531,12 +602,146 @@ void App_FlowField::AddWall(Elite::Vector2 pos)
 }
 void App_FlowField::ReCalculateFlowField()
 {
-	CalculateHeatMap(m_DestinationNodeIndex);
+	if (m_bUseSectors)
+	{
+		ReCalculateSectorFlowField();
+		return;
+	}
+
+	// Going back to a goal that was used on the same terrain is a lookup, only single destinations are cached
+	const bool isCacheable = HasSingleDestination();
+	const auto pCachedField = isCacheable ? m_FlowFieldCache.Find(m_DestinationNodeIndex, m_pTerrainGraph->GetRevision()) : nullptr;
+	if (pCachedField != nullptr)
+	{
+		// A field that is still being built for an older destination must not replace the restored one
+		m_FlowFieldBuilder.Discard();
+		m_IntegrationField.Restore(m_pTerrainGraph.get(), GetDestinationSeeds(), pCachedField->costs);
+		m_VectorField.Restore(m_pTerrainGraph.get(), pCachedField->cells);
+		return;
+	}
+
+	if (m_bBuildInBackground)
+	{
+		RequestFlowField();
+		return;
+	}
+
+	m_FlowFieldBuilder.Discard();
+	CalculateHeatMap();
 	CalculateVectorField();
+
+	if (isCacheable)
+	{
+		m_FlowFieldCache.Store(m_DestinationNodeIndex, m_pTerrainGraph->GetRevision(), m_IntegrationField.GetCosts(), m_VectorField.GetCells());
+	}
+}
+void App_FlowField::RequestFlowField()
+{
+	// The builder works on a snapshot of the grid, so the terrain can be edited again before it is done
+	const int lineOfSightGoal = HasSingleDestination() ? m_DestinationNodeIndex : invalid_node_id;
+	m_FlowFieldBuilder.Request(m_pTerrainGraph.get(), GetDestinationSeeds(), m_pTerrainGraph->IsConnectedDiagonally(), lineOfSightGoal);
+}
+void App_FlowField::PublishFlowField()
+{
+	// Agents only read the fields during their update, so swapping in the newest finished ones here never tears a frame
+	if (!m_FlowFieldBuilder.TryPublish(m_IntegrationField, m_VectorField)) return;
+
+	// Only the field of the newest request matches the current terrain and destination
+	if (HasSingleDestination() && m_FlowFieldBuilder.GetPublishedGeneration() == m_FlowFieldBuilder.GetRequestedGeneration())
+	{
+		m_FlowFieldCache.Store(m_DestinationNodeIndex, m_pTerrainGraph->GetRevision(), m_IntegrationField.GetCosts(), m_VectorField.GetCells());
+	}
+}
+void App_FlowField::ReCalculateSectorFlowField()
+{
+	// The portal graph only has to be rebuilt when the grid or its connections changed
+	if (m_IsSectorGraphDirty)
+	{
+		m_SectorFlowField.Build(m_pTerrainGraph.get(), m_SectorSize);
+		m_IsSectorGraphDirty = false;
+	}
+
+	// Only the sectors between the agents and the destination get a flow field
+	m_AgentNodeIndices.clear();
+	for (const Vector2& agentPos : m_AgentPositions)
+	{
+		m_AgentNodeIndices.push_back(m_pTerrainGraph->GetNodeIdAtPosition(agentPos));
+	}
+	m_SectorFlowField.Calculate(m_pTerrainGraph.get(), m_DestinationNodeIndex, m_AgentNodeIndices);
+}
+Elite::Vector2 App_FlowField::GetDirectionAtNode(int nodeIndex) const
+{
+	return m_bUseSectors ? m_SectorFlowField.GetDirection(nodeIndex) : m_VectorField.GetVector(nodeIndex);
+}
+float App_FlowField::GetCostAtNode(int nodeIndex) const
+{
+	return m_bUseSectors ? m_SectorFlowField.GetCost(nodeIndex) : m_IntegrationField.GetCost(nodeIndex);
+}
+void App_FlowField::RepairFlowField(int modifiedNodeIndex)
+{
+	// The portal graph has no incremental update, so it is rebuilt for the edited grid
+	if (m_bUseSectors)
+	{
+		m_IsSectorGraphDirty = true;
+		ReCalculateSectorFlowField();
+		return;
+	}
+
+	// Without a destination there is nothing to repair
+	if (!HasDestination()) return;
+
+	// In the background the builder repairs the field it built last with the cells that changed since, the same repair as below
+	if (m_bBuildInBackground)
+	{
+		RequestFlowField();
+		return;
+	}
+
+	// Only re-propagate the costs that actually changed because of the edit
+	m_IntegrationField.Repair(m_pTerrainGraph.get(), { modifiedNodeIndex }, m_RepairedNodes);
+
+	// A direction only depends on the costs of the node's neighbours, so only the nodes around the repaired ones need a new one
+	m_RepairedNodes.push_back(modifiedNodeIndex);
+	m_RecalculatedNodes.clear();
+	for (int nodeIndex : m_RepairedNodes)
+	{
+		auto [row, col] = m_pTerrainGraph->GetRowAndColumn(nodeIndex);
+		for (int rowOffset = -1; rowOffset <= 1; ++rowOffset)
+		{
+			for (int colOffset = -1; colOffset <= 1; ++colOffset)
+			{
+				if (m_pTerrainGraph->IsWithinBounds(col + colOffset, row + rowOffset))
+				{
+					const int neighborIndex = m_pTerrainGraph->GetNodeId(col + colOffset, row + rowOffset);
+					m_VectorField.CalculateAtNode(m_pTerrainGraph.get(), m_IntegrationField.GetCosts(), neighborIndex);
+					m_RecalculatedNodes.push_back(neighborIndex);
+				}
+			}
+		}
+	}
+
+	if (!HasSingleDestination()) return;
+
+	// A wall or mud casts a shadow behind it, only the cells behind the recalculated ones are swept again
+	m_VectorField.CalculateLineOfSight(m_pTerrainGraph.get(), m_DestinationNodeIndex, m_RecalculatedNodes);
+
+	// The edit made every cached field outdated, the repaired one is up to date again
+	m_FlowFieldCache.Store(m_DestinationNodeIndex, m_pTerrainGraph->GetRevision(), m_IntegrationField.GetCosts(), m_VectorField.GetCells());
 }
 void App_FlowField::ResetFields()
 {
 	InitializeHeatMap();
-	m_VectorField.resize(m_NrOfCols * m_NrOfRows);
+	m_VectorField.Clear(m_pTerrainGraph.get());
+	m_IsSectorGraphDirty = true;
+
+	// Fields that are still being built belong to the old grid
+	m_FlowFieldBuilder.Discard();
+
+	// A new grid starts counting its terrain revisions from the start again
+	m_FlowFieldCache.Clear();
+
+	// The destinations are node ids of the old grid, which can be out of range of the new one
+	m_DestinationNodeIndex = invalid_node_id;
+	m_ExtraDestinationNodeIndices.clear();
 
 }
\ No newline at end of file
@@ -8,12 +8,16 @@
 #include "framework/EliteAI/EliteGraphs/EliteGraphUtilities/EGraphEditor.h"
 #include "framework/EliteAI/EliteGraphs/EliteGraphUtilities/EGraphRenderer.h"
 #include "framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/EHeuristic.h"
+#include "framework/EliteAI/EliteGraphs/EliteFlowField/EIntegrationField.h"
+#include "framework/EliteAI/EliteGraphs/EliteFlowField/EDirectionField.h"
+#include "framework/EliteAI/EliteGraphs/EliteFlowField/ESectorFlowField.h"
+#include "framework/EliteAI/EliteGraphs/EliteFlowField/EFlowFieldCache.h"
+#include "framework/EliteAI/EliteGraphs/EliteFlowField/EFlowFieldBuilder.h"
+#include "framework/EliteHelpers/EThreadPool.h"
 
-#include "projects/Movement/SteeringBehaviors/SteeringAgent.h"
 #include "projects/Shared/NavigationColliderElement.h"
 
 //Forward declerations
-class SteeringAgent;
 class PathFollow;
 
 //-----------------------------------------------------------------
@@ -47,11 +51,16 @@ private:
 	std::list<std::unique_ptr<NavigationColliderElement>> m_lWalls;
 
 
-	std::vector<int> m_HeatMap{};
+	Elite::IntegrationField m_IntegrationField{};
 
 	int m_DestinationNodeIndex{ invalid_node_id };
 
+	// Every agent walks to the nearest destination
+	bool m_bAddDestinations{ false };
+	std::vector<int> m_ExtraDestinationNodeIndices{};
+
 	Elite::Vector2 m_WorldSize{};
+	static constexpr int MAX_GRID_SIZE{ 1024 };
 
 	//Editor and Visualisation
 	Elite::GraphEditor m_GraphEditor{};
@@ -61,13 +70,36 @@ private:
 
 	int m_NrOfAgents{ 500 };
 	int m_PreviousNrOfAgents{};
+	float m_AgentSpeed{ 25.f };
 
-	std::vector<std::unique_ptr<SteeringAgent>> m_vAgents;
+	// Agents are particles that only follow the flow field: their data lives in contiguous arrays,
+	// updated in batches on the thread pool without allocating
+	std::vector<Elite::Vector2> m_AgentPositions{};
+	Elite::ThreadPool m_ThreadPool{};
+	static constexpr int AGENT_BATCH_SIZE{ 1024 };
 
 
 	// ---------- Flow Field datamembers -------------- //
 
-	std::vector<Elite::Vector2> m_VectorField{};
+	// One encoded byte per cell: direction towards the cheapest neighbour, line of sight, pathable and goal flags
+	Elite::DirectionField m_VectorField{};
+	std::vector<int> m_RepairedNodes{};
+	std::vector<int> m_RecalculatedNodes{};
+	Elite::FlowFieldCache m_FlowFieldCache{};
+
+	// Edits and new destinations are built on a worker thread, agents keep following the last published field meanwhile
+	bool m_bBuildInBackground{ true };
+	bool m_PreviousBuildInBackground{ true };
+	Elite::FlowFieldBuilder m_FlowFieldBuilder{};
+
+	// Hierarchical mode: only the sectors between the agents and the destination get a flow field
+	bool m_bUseSectors{ false };
+	bool m_PreviousUseSectors{ false };
+	int m_SectorSize{ 10 };
+	int m_PreviousSectorSize{ 10 };
+	bool m_IsSectorGraphDirty{ true };
+	Elite::SectorFlowField m_SectorFlowField{};
+	std::vector<int> m_AgentNodeIndices{};
 
 	// -------- Debug rendering information -------- //
 
@@ -80,7 +112,9 @@ private:
 	// Flow Field Debug
 	bool m_bDrawHeatMap{ false };
 	bool m_bDrawVectorField{ false };
+	bool m_bDrawAgents{ true };
 	std::vector<std::unique_ptr<Elite::Polygon>> m_CellPolygons;
+	static constexpr size_t MAX_HEATMAP_VALUES{ 100 * 100 };
 
 	// Pathfinding Debug
 	bool m_StartSelected{ true };
@@ -94,17 +128,27 @@ private:
 	void MakeGridGraph();
 	void UpdateImGui();
 	void UpdateGridSettings();
+	void UpdateFlowFieldSettings();
 
 	// HeatMap 
 	void InitializeHeatMap();
 	void InitializeHeatMapPolygons();
-	void CalculateHeatMap(int goalNodeIndex);
+	void CalculateHeatMap();
+	std::vector<Elite::IntegrationSeed> GetDestinationSeeds() const;
+	bool HasDestination() const;
+	bool HasSingleDestination() const;
 
 	void RenderHeatMap() const;
 
 	// Flow Field
 	void CalculateVectorField();
 	void ReCalculateFlowField();
+	void RequestFlowField();
+	void PublishFlowField();
+	void RepairFlowField(int modifiedNodeIndex);
+	void ReCalculateSectorFlowField();
+	Elite::Vector2 GetDirectionAtNode(int nodeIndex) const;
+	float GetCostAtNode(int nodeIndex) const;
 	void RenderVectorField() const;
 	void ResetFields();
 
@@ -115,10 +159,13 @@ private:
 	void HandleRightMouseButton();
 	void ToggleWallAtNode(Elite::TerrainGraphNode* node);
 	void ToggleTerrainTypeAtNode(Elite::TerrainGraphNode* node);
+	bool IsWallAtNode(int nodeIndex) const;
 	Elite::Vector2 GetMousePosition(const Elite::InputMouseButton& mouseButton);
 
 	// Agents
-	void UpdateAgents();
+	void UpdateAgents(float deltaTime);
+	void UpdateAgentBatch(int firstAgent, int endAgent, float deltaTime);
+	void RenderAgents() const;
 	void ResetAgents();
 	void UpdateAgentSettings();
 
@@ -126,7 +173,7 @@ private:
 
 
 	// Debug Functions
-	Elite::Color ValueToColor(int value, int maxHeatmapValue) const;
+	Elite::Color ValueToColor(float value, float maxHeatmapValue) const;
 
 	// Helper Functions
 	std::unique_ptr<Elite::Polygon> MakeRectanglePolygon(const Elite::Vector2& center, const Elite::Vector2& size) const;
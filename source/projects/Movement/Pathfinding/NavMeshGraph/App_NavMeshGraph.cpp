@@ -11,7 +11,7 @@ using namespace Elite;
 #include "projects/Movement/SteeringBehaviors/SteeringAgent.h"
 #include "projects/Movement/SteeringBehaviors/PathFollow/PathFollowSteeringBehavior.h"
 
-#include "framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/ENavGraphPathfinding.h"
+#include "framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/EPathRequestQueue.h"
 #include "framework/EliteAI/EliteGraphs/EliteNavGraph/ENavGraph.h"
 
 
@@ -31,6 +31,7 @@ App_NavMeshGraph::~App_NavMeshGraph()
 		SAFE_DELETE(pNC);
 	m_vNavigationColliders.clear();
 
+	SAFE_DELETE(m_pPathRequestQueue);
 	SAFE_DELETE(m_pNavGraph);
 	SAFE_DELETE(m_pPathFollow);
 	SAFE_DELETE(m_pAgent);
@@ -55,6 +56,7 @@ void App_NavMeshGraph::Start()
 
 	const auto& shapes = PHYSICSWORLD->GetAllStaticShapesInWorld(PhysicsFlags::NavigationCollider);
 	m_pNavGraph = new Elite::NavGraph(shapes, 120,60, m_AgentRadius);
+	m_pPathRequestQueue = new PathRequestQueue(m_pNavGraph);
 
 	//----------- AGENT ------------
 	m_pPathFollow = new PathFollow();
@@ -77,17 +79,26 @@ void App_NavMeshGraph::Update(float deltaTime)
 		auto mouseData = INPUTMANAGER->GetMouseData(Elite::InputType::eMouseButton, Elite::InputMouseButton::eLeft);
 		Elite::Vector2 mouseTarget = DEBUGRENDERER2D->GetActiveCamera()->ConvertScreenToWorld(
 			Elite::Vector2((float)mouseData.X, (float)mouseData.Y));
-		m_vPath = NavMeshPathfinding::FindPath(m_pAgent->GetPosition(), mouseTarget, m_pNavGraph, m_DebugNodePositions, m_Portals);
 
-		//Check if a path exist and move to the following point
-		if (m_vPath.size() > 0)
-		{
-			m_pPathFollow->SetPath(m_vPath);
-		}
+		//The query is solved by the queue during the Update below
+		m_pPathRequestQueue->Request(m_pAgent->GetPosition(), mouseTarget, 0,
+			[this](int, const PathRequestQueue::NavMeshPath& result)
+			{
+				m_vPath = result.path;
+				m_DebugNodePositions = result.nodePositions;
+				m_Portals = result.portals;
+
+				//Check if a path exist and move to the following point
+				if (m_vPath.size() > 0)
+				{
+					m_pPathFollow->SetPath(m_vPath);
+				}
+			});
 	}
 
-	
-	
+	//Solve the queued path requests, the callbacks hand the paths to the agent
+	m_pPathRequestQueue->Update(PATH_REQUEST_BUDGET);
+
 	UpdateImGui();
 	m_pAgent->Update(deltaTime);
 }
@@ -15,6 +15,7 @@ namespace Elite
 {
 	class NavGraph;
 	class GraphRenderer;
+	class PathRequestQueue;
 }
 
 
@@ -47,6 +48,8 @@ private:
 
 	// --Pathfinder--
 	std::vector<Elite::Vector2> m_vPath;
+	Elite::PathRequestQueue* m_pPathRequestQueue = nullptr;
+	const float PATH_REQUEST_BUDGET = 1.f; //ms per frame
 
 	// --Graph--
 	Elite::NavGraph* m_pNavGraph = nullptr;
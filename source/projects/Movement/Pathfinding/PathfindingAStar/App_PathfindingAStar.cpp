@@ -13,6 +13,10 @@ using namespace Elite;
 //Destructor
 App_PathfindingAStar::~App_PathfindingAStar()
 {
+	SAFE_DELETE(m_pPathRequestQueue);
+	SAFE_DELETE(m_pLandmarkHeuristic);
+	SAFE_DELETE(m_pJumpPointSearch);
+	SAFE_DELETE(m_pHierarchicalAStar);
 	SAFE_DELETE(m_pTerrainGraph);
 
 	SAFE_DELETE(m_pAgent);
@@ -28,6 +32,7 @@ void App_PathfindingAStar::Start()
 
 	//Create Graph
 	MakeGridGraph();
+	MakePathfinders();
 
 	//Create Agent
 	m_pPathFollowBehavior = new PathFollow();
@@ -78,6 +83,12 @@ void App_PathfindingAStar::Update(float deltaTime)
 		CalculatePath();
 	}
 
+	//Rebuild the landmark tables in the background after an edit, the searches ignore them until they are up to date
+	m_pLandmarkHeuristic->Update();
+
+	//Solve the queued path requests, the callbacks hand the paths to the agent
+	m_pPathRequestQueue->Update(PATH_REQUEST_BUDGET);
+
 	m_pAgent->Update(deltaTime);
 }
 
@@ -118,7 +129,8 @@ void App_PathfindingAStar::Render(float deltaTime) const
 
 void App_PathfindingAStar::MakeGridGraph()
 {
-	m_pTerrainGraph = new TerrainGridGraph(COLUMNS, ROWS, m_SizeCell, false, false, static_cast<float>(m_SizeCell), m_SizeCell* 1.5f);
+	//Jump point search only jumps on a diagonally connected grid
+	m_pTerrainGraph = new TerrainGridGraph(COLUMNS, ROWS, m_SizeCell, false, m_bUseJumpPointSearch, static_cast<float>(m_SizeCell), m_SizeCell* 1.5f);
 
 	//Setup default terrain
 	m_pTerrainGraph->SetNodeTerrainType(86, TerrainType::Water);
@@ -131,6 +143,55 @@ void App_PathfindingAStar::MakeGridGraph()
 	m_pTerrainGraph->RemoveAllConnectionsWithNode(47);
 }
 
+void App_PathfindingAStar::MakePathfinders()
+{
+	m_pJumpPointSearch = new JumpPointSearch(m_pTerrainGraph);
+	m_pHierarchicalAStar = new HierarchicalAStar(m_pTerrainGraph, 5);
+	m_pPathRequestQueue = new PathRequestQueue(m_pTerrainGraph);
+	m_pLandmarkHeuristic = new LandmarkHeuristic(m_pTerrainGraph, 4);
+	m_pPathRequestQueue->SetLandmarkHeuristic(m_bUseLandmarks ? m_pLandmarkHeuristic : nullptr);
+}
+
+void App_PathfindingAStar::UpdateGridConnections()
+{
+	//Jump point search gets a diagonally connected grid, the other searches keep the straight one
+	if (m_pTerrainGraph->IsConnectedDiagonally() == m_bUseJumpPointSearch)
+		return;
+
+	//Keep the terrain that was painted on the old grid
+	std::vector<TerrainType> terrainTypes{};
+	terrainTypes.reserve(COLUMNS * ROWS);
+	for (int nodeId = 0; nodeId < COLUMNS * ROWS; ++nodeId)
+	{
+		terrainTypes.push_back(m_pTerrainGraph->GetDenseGrid().GetTerrainType(nodeId));
+	}
+
+	SAFE_DELETE(m_pPathRequestQueue);
+	SAFE_DELETE(m_pLandmarkHeuristic);
+	SAFE_DELETE(m_pJumpPointSearch);
+	SAFE_DELETE(m_pHierarchicalAStar);
+	SAFE_DELETE(m_pTerrainGraph);
+	m_vPath.clear();
+
+	MakeGridGraph();
+
+	//Paint it on the new grid the way the graph editor does, only where it differs from the default terrain
+	for (int nodeId = 0; nodeId < COLUMNS * ROWS; ++nodeId)
+	{
+		if (m_pTerrainGraph->GetDenseGrid().GetTerrainType(nodeId) == terrainTypes[nodeId])
+			continue;
+
+		m_pTerrainGraph->SetNodeTerrainType(nodeId, terrainTypes[nodeId]);
+		m_pTerrainGraph->RemoveAllConnectionsWithNode(nodeId);
+		if (terrainTypes[nodeId] != TerrainType::Water)
+		{
+			m_pTerrainGraph->AddConnectionsToAdjacentCells(nodeId);
+		}
+	}
+
+	MakePathfinders();
+}
+
 void App_PathfindingAStar::UpdateImGui()
 {
 #ifdef PLATFORM_WINDOWS
@@ -184,6 +245,32 @@ void App_PathfindingAStar::UpdateImGui()
 		ImGui::Checkbox("NodeNumbers", &m_bDrawNodeNumbers);
 		ImGui::Checkbox("Connections", &m_bDrawConnections);
 		ImGui::Checkbox("Connections Costs", &m_bDrawConnectionsCosts);
+		if (ImGui::Checkbox("Jump Point Search", &m_bUseJumpPointSearch))
+		{
+			m_bUseHierarchicalAStar = false;
+			m_bUseBidirectional = false;
+			UpdateGridConnections();
+			CalculatePath();
+		}
+		if (ImGui::Checkbox("HPA*", &m_bUseHierarchicalAStar))
+		{
+			m_bUseJumpPointSearch = false;
+			m_bUseBidirectional = false;
+			UpdateGridConnections();
+			CalculatePath();
+		}
+		if (ImGui::Checkbox("Bidirectional", &m_bUseBidirectional))
+		{
+			m_bUseJumpPointSearch = false;
+			m_bUseHierarchicalAStar = false;
+			UpdateGridConnections();
+			CalculatePath();
+		}
+		if (ImGui::Checkbox("Landmarks (ALT)", &m_bUseLandmarks))
+		{
+			m_pPathRequestQueue->SetLandmarkHeuristic(m_bUseLandmarks ? m_pLandmarkHeuristic : nullptr);
+			CalculatePath();
+		}
 		if (ImGui::Combo("", &m_SelectedHeuristic, "Manhattan\0Euclidean\0SqEuclidean\0Octile\0Chebyshev", 4))
 		{
 			switch (m_SelectedHeuristic)
@@ -223,15 +310,48 @@ void App_PathfindingAStar::CalculatePath()
 		&& m_endPathId != invalid_node_id
 		&& m_startPathId != m_endPathId)
 	{
-		//Select (uncomment) BFS Pathfinding or A* Pathfinding
-		//auto pathfinder = BFS(m_pTerrainGraph);
-		auto pathfinder = AStar(m_pTerrainGraph, m_heuristicFunction);
 		auto startNode = m_pTerrainGraph->GetNode(m_startPathId);
 		auto endNode = m_pTerrainGraph->GetNode(m_endPathId);
 
-		m_vPath = pathfinder.FindPath(startNode, endNode);
-		std::cout << "New path calculated using " << typeid(pathfinder).name() << std::endl;
-		UpdateAgentPath(m_vPath);
+		//An older request that is still waiting would overwrite this path
+		m_pPathRequestQueue->Clear();
+
+		//Jump point search uses its own octile heuristic and only jumps over open ground
+		if (m_bUseJumpPointSearch)
+		{
+			m_vPath = m_pJumpPointSearch->FindPath(startNode, endNode);
+			std::cout << "New path calculated using jump point search, " << m_pJumpPointSearch->GetNrOfExpandedNodes() << " nodes expanded" << std::endl;
+			UpdateAgentPath(m_vPath);
+			return;
+		}
+
+		//HPA* searches the entrances between the clusters of 5x5 cells, edited clusters are rebuilt by the next search
+		if (m_bUseHierarchicalAStar)
+		{
+			m_vPath = m_pHierarchicalAStar->FindPath(startNode, endNode);
+			std::cout << "New path calculated using HPA*, " << m_pHierarchicalAStar->GetNrOfRebuiltClusters() << " clusters rebuilt after the last edit" << std::endl;
+			UpdateAgentPath(m_vPath);
+			return;
+		}
+
+		//Bidirectional A* searches from the start and the end node at once, and stops once they can't find a cheaper meeting point
+		if (m_bUseBidirectional)
+		{
+			AStar<Heuristic, GridNodePositions> pathfinder{ m_pTerrainGraph, m_heuristicFunction, m_bUseLandmarks ? m_pLandmarkHeuristic : nullptr };
+			m_vPath = pathfinder.FindPathBidirectional(startNode, endNode);
+			std::cout << "New path calculated using bidirectional A*, " << pathfinder.GetNrOfExpandedNodes() << " nodes expanded" << std::endl;
+			UpdateAgentPath(m_vPath);
+			return;
+		}
+
+		//A* requests are solved by the queue during the next Update
+		m_pPathRequestQueue->Request(m_startPathId, m_endPathId, m_heuristicFunction, 0,
+			[this](int, const std::vector<GraphNode*>& path)
+			{
+				m_vPath = path;
+				std::cout << "New path calculated using A* (path request queue)" << (m_bUseLandmarks ? " with landmarks" : "") << std::endl;
+				UpdateAgentPath(m_vPath);
+			});
 	}
 	else
 	{
@@ -8,6 +8,10 @@
 #include "framework/EliteAI/EliteGraphs/EliteGraphUtilities/EGraphEditor.h"
 #include "framework/EliteAI/EliteGraphs/EliteGraphUtilities/EGraphRenderer.h"
 #include "framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/EHeuristic.h"
+#include "framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/EJumpPointSearch.h"
+#include "framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/EHierarchicalAStar.h"
+#include "framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/EPathRequestQueue.h"
+#include "framework/EliteAI/EliteGraphs/EliteGraphAlgorithms/ELandmarkHeuristic.h"
 
 //Forward declerations
 class SteeringAgent;
@@ -44,6 +48,15 @@ private:
 	int m_startPathId = invalid_node_id;
 	int m_endPathId = invalid_node_id;
 	std::vector<Elite::GraphNode*> m_vPath;
+	bool m_bUseJumpPointSearch = false;
+	Elite::JumpPointSearch* m_pJumpPointSearch = nullptr;
+	bool m_bUseHierarchicalAStar = false;
+	bool m_bUseBidirectional = false;
+	Elite::HierarchicalAStar* m_pHierarchicalAStar = nullptr;
+	Elite::PathRequestQueue* m_pPathRequestQueue = nullptr;
+	bool m_bUseLandmarks = false;
+	Elite::LandmarkHeuristic* m_pLandmarkHeuristic = nullptr;
+	const float PATH_REQUEST_BUDGET = 1.f; //ms per frame
 
 	//Editor and Visualisation
 	Elite::GraphEditor m_GraphEditor{};
@@ -65,6 +78,8 @@ private:
 
 	//Functions
 	void MakeGridGraph();
+	void MakePathfinders();
+	void UpdateGridConnections();
 	void UpdateImGui();
 	void CalculatePath();
 	void UpdateAgentPath(const std::vector<Elite::GraphNode*>& path);